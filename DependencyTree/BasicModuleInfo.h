@@ -33,38 +33,38 @@ protected:
 
 //---------------------
 
-BasicModuleInfo::BasicModuleInfo ():
+inline BasicModuleInfo::BasicModuleInfo ():
 	m_errbuff   (""),
 	m_has_error (false)
 {}
 
 //---------------------
 
-const char* BasicModuleInfo::getError () const
+inline const char* BasicModuleInfo::getError () const
 {
 	return m_has_error? m_errbuff: "No error";
 }
 
-bool BasicModuleInfo::hasError () const
+inline bool BasicModuleInfo::hasError () const
 {
 	return m_has_error;
 }
 
-void BasicModuleInfo::clearError ()
+inline void BasicModuleInfo::clearError ()
 {
 	m_has_error = false;
 }
 
 //---------------------
 
-bool BasicModuleInfo::ok () const
+inline bool BasicModuleInfo::ok () const
 {
 	return !m_has_error;
 }
 
 //---------------------
 
-void BasicModuleInfo::formatError (const char* format, ...)
+inline void BasicModuleInfo::formatError (const char* format, ...)
 {
 	va_list args = {};
 	va_start (args, format);
@@ -80,7 +80,7 @@ void BasicModuleInfo::formatError (const char* format, ...)
 
 //---------------------
 
-char* FormatWinapiError (char* errbuff, size_t max, int err)
+inline char* FormatWinapiError (char* errbuff, size_t max, int err)
 {
 	const char* remove = "\n\r.";
 
@@ -96,7 +96,7 @@ char* FormatWinapiError (char* errbuff, size_t max, int err)
 	return errbuff;
 }
 
-const char* FormatWinapiError (int err)
+inline const char* FormatWinapiError (int err)
 {
 	static char errbuff[BUFFSIZE] = "";
 	return FormatWinapiError (errbuff, BUFFSIZE, err);
@@ -0,0 +1,196 @@
+#include <cassert>
+
+#include "Condensation.h"
+
+//--------------------------------
+
+Condensation::Condensation ():
+	m_component     (),
+	m_members       (),
+	m_members_start (),
+	m_self_import   (),
+	m_dependencies  (),
+	m_dependents    ()
+{}
+
+//--------------------------------
+
+void Condensation::build (const DependencyGraph& graph)
+{
+	int count = graph.getModulesCount ();
+
+	std::vector <int>  index    (count, -1);
+	std::vector <int>  lowlink  (count,  0);
+	std::vector <char> on_stack (count,  0);
+	std::vector <int>  stack;
+	std::vector <std::pair <int, size_t>> calls;
+
+	m_component.assign (count, -1);
+
+	int next_index     = 0;
+	int next_component = 0;
+
+	for (int root = 0; root < count; root++)
+	{
+		if (index[root] != -1) continue;
+
+		calls.push_back ({root, 0});
+		while (!calls.empty ())
+		{
+			int     node = calls.back ().first;
+			size_t& edge = calls.back ().second;
+
+			if (edge == 0)
+			{
+				index[node] = lowlink[node] = next_index++;
+				stack.push_back (node);
+				on_stack[node] = 1;
+			}
+
+			const std::vector <int>& dependencies = graph.getDependencies (node);
+			if (edge < dependencies.size ())
+			{
+				int next = dependencies[edge++];
+				if (index[next] == -1)
+					calls.push_back ({next, 0});
+
+				else if (on_stack[next] && index[next] < lowlink[node])
+					lowlink[node] = index[next];
+
+				continue;
+			}
+
+			if (lowlink[node] == index[node])
+			{
+				int member = -1;
+				do
+				{
+					member = stack.back ();
+					stack.pop_back ();
+
+					on_stack   [member] = 0;
+					m_component[member] = next_component;
+				}
+				while (member != node);
+
+				next_component++;
+			}
+
+			calls.pop_back ();
+			if (!calls.empty ())
+			{
+				int caller = calls.back ().first;
+				if (lowlink[node] < lowlink[caller])
+					lowlink[caller] = lowlink[node];
+			}
+		}
+	}
+
+	m_members_start.assign (next_component + 1, 0);
+	for (int module = 0; module < count; module++)
+		m_members_start[m_component[module] + 1]++;
+
+	for (int c = 0; c < next_component; c++)
+		m_members_start[c+1] += m_members_start[c];
+
+	std::vector <int> fill (m_members_start.begin (), m_members_start.end () - 1);
+	m_members.assign (count, 0);
+	for (int module = 0; module < count; module++)
+		m_members[fill[m_component[module]]++] = module;
+
+	connect (graph);
+}
+
+//--------------------------------
+
+void Condensation::connect (const DependencyGraph& graph)
+{
+	int count = getComponentsCount ();
+
+	m_dependencies.assign (count, {});
+	m_dependents  .assign (count, {});
+	m_self_import .assign (count, 0);
+
+	std::vector <int> seen (count, -1);
+
+	for (int c = 0; c < count; c++)
+	{
+		for (int i = m_members_start[c]; i < m_members_start[c+1]; i++)
+		{
+			for (int dependency: graph.getDependencies (m_members[i]))
+			{
+				int target = m_component[dependency];
+				if (target == c)
+				{
+					m_self_import[c] |= dependency == m_members[i];
+					continue;
+				}
+
+				if (seen[target] == c) continue;
+				seen[target] = c;
+
+				m_dependencies[c     ].push_back (target);
+				m_dependents  [target].push_back (c     );
+			}
+		}
+	}
+}
+
+//--------------------------------
+
+int Condensation::getComponentsCount () const
+{
+	return m_members_start.empty ()? 0: (int) m_members_start.size () - 1;
+}
+
+int Condensation::getComponent (int module) const
+{
+	assert (module >= 0 && module < (int) m_component.size ());
+	return m_component[module];
+}
+
+//--------------------------------
+
+int Condensation::getMembersCount (int component) const
+{
+	assert (component >= 0 && component < getComponentsCount ());
+	return m_members_start[component+1] - m_members_start[component];
+}
+
+const int* Condensation::getMembers (int component) const
+{
+	assert (component >= 0 && component < getComponentsCount ());
+	return m_members.data () + m_members_start[component];
+}
+
+//--------------------------------
+
+const std::vector <int>& Condensation::getDependencies (int component) const
+{
+	assert (component >= 0 && component < getComponentsCount ());
+	return m_dependencies[component];
+}
+
+const std::vector <int>& Condensation::getDependents (int component) const
+{
+	assert (component >= 0 && component < getComponentsCount ());
+	return m_dependents[component];
+}
+
+//--------------------------------
+
+bool Condensation::isCycle (int component) const
+{
+	return getMembersCount (component) > 1 || m_self_import[component];
+}
+
+std::vector <int> Condensation::getCycles () const
+{
+	std::vector <int> cycles;
+	for (int c = 0, count = getComponentsCount (); c < count; c++)
+		if (isCycle (c)) cycles.push_back (c);
+
+	return cycles;
+}
+
+//--------------------------------
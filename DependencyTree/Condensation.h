@@ -0,0 +1,50 @@
+#pragma once
+
+//--------------------------------
+
+#include <vector>
+
+#include "DependencyGraph.h"
+
+//--------------------------------
+
+// Strongly connected components of a scan and the DAG between them.
+//
+// Components are computed with an iterative Tarjan pass, so deep import
+// chains never touch the C++ stack. They are numbered in the order Tarjan
+// finishes them, which is reverse topological: every dependency of a
+// component has a smaller number than the component itself.
+
+class Condensation
+{
+public :
+	Condensation ();
+
+	void build (const DependencyGraph& graph);
+
+	int getComponentsCount () const;
+	int getComponent       (int module) const;
+
+	int        getMembersCount (int component) const;
+	const int* getMembers      (int component) const;
+
+	const std::vector <int>& getDependencies (int component) const;
+	const std::vector <int>& getDependents   (int component) const;
+
+	bool              isCycle   (int component) const;
+	std::vector <int> getCycles () const;
+
+private :
+	std::vector <int>               m_component;
+	std::vector <int>               m_members;
+	std::vector <int>               m_members_start;
+	std::vector <char>              m_self_import;
+
+	std::vector <std::vector <int>> m_dependencies;
+	std::vector <std::vector <int>> m_dependents;
+
+	void connect (const DependencyGraph& graph);
+
+};
+
+//--------------------------------
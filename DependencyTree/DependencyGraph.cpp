@@ -0,0 +1,315 @@
+#include <cstdio>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+
+#include "DependencyGraph.h"
+
+//--------------------------------
+
+static const char*  SnapshotSignature  = "DependencyTree scan 1";
+static const size_t SnapshotLineLength = 4096;
+
+const std::vector <std::string> DependencyGraph::NoImports;
+
+//--------------------------------
+
+DependencyGraph::DependencyGraph ():
+	m_modules (),
+	m_index   (),
+	m_edges   ()
+{}
+
+//--------------------------------
+
+std::string DependencyGraph::MakeKey (const char* name)
+{
+	std::string key (name);
+	for (char& c: key)
+		c = (char) tolower ((unsigned char) c);
+
+	return key;
+}
+
+//--------------------------------
+
+int DependencyGraph::addModule (const char* name)
+{
+	std::string key = MakeKey (name);
+
+	auto found = m_index.find (key);
+	if (found != m_index.end ())
+		return found -> second;
+
+	int index = (int) m_modules.size ();
+	m_modules.push_back ({name, 0, {}, {}, {}, HashImports ({})});
+	m_index.emplace (std::move (key), index);
+
+	return index;
+}
+
+int DependencyGraph::findModule (const char* name) const
+{
+	auto found = m_index.find (MakeKey (name));
+	return found != m_index.end ()? found -> second: -1;
+}
+
+//--------------------------------
+
+bool DependencyGraph::addEdge (int from, int to)
+{
+	assert (from >= 0 && from < getModulesCount ());
+	assert (to   >= 0 && to   < getModulesCount ());
+
+	uint64_t key = (uint64_t) (uint32_t) from << 32 | (uint32_t) to;
+	if (!m_edges.insert (key).second)
+		return false;
+
+	m_modules[from].dependencies.push_back (to  );
+	m_modules[to  ].dependents  .push_back (from);
+	return true;
+}
+
+//--------------------------------
+
+void DependencyGraph::addFlags (int module, unsigned flags)
+{
+	assert (module >= 0 && module < getModulesCount ());
+	m_modules[module].flags |= flags;
+}
+
+unsigned DependencyGraph::getFlags (int module) const
+{
+	assert (module >= 0 && module < getModulesCount ());
+	return m_modules[module].flags;
+}
+
+//--------------------------------
+
+// FNV-1a over the sorted list, with a separator between symbols so
+// {"ab", "c"} and {"a", "bc"} do not collide.
+
+uint64_t DependencyGraph::HashImports (const std::vector <std::string>& imports)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (const std::string& symbol: imports)
+	{
+		for (char c: symbol)
+			hash = (hash ^ (unsigned char) c) * 1099511628211ull;
+
+		hash = (hash ^ '\n') * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+//--------------------------------
+
+void DependencyGraph::setImports (int module, Imports imports)
+{
+	assert (module >= 0 && module < getModulesCount ());
+	assert (!imports || std::is_sorted (imports -> begin (), imports -> end ()));
+
+	m_modules[module].imports_hash = HashImports (imports? *imports: NoImports);
+	m_modules[module].imports      = std::move (imports);
+}
+
+const std::vector <std::string>& DependencyGraph::getImports (int module) const
+{
+	assert (module >= 0 && module < getModulesCount ());
+	return m_modules[module].imports? *m_modules[module].imports: NoImports;
+}
+
+uint64_t DependencyGraph::getImportsHash (int module) const
+{
+	assert (module >= 0 && module < getModulesCount ());
+	return m_modules[module].imports_hash;
+}
+
+//--------------------------------
+
+int DependencyGraph::getModulesCount () const
+{
+	return (int) m_modules.size ();
+}
+
+int DependencyGraph::getEdgesCount () const
+{
+	return (int) m_edges.size ();
+}
+
+//--------------------------------
+
+const char* DependencyGraph::getModuleName (int module) const
+{
+	assert (module >= 0 && module < getModulesCount ());
+	return m_modules[module].name.c_str ();
+}
+
+const std::vector <int>& DependencyGraph::getDependencies (int module) const
+{
+	assert (module >= 0 && module < getModulesCount ());
+	return m_modules[module].dependencies;
+}
+
+const std::vector <int>& DependencyGraph::getDependents (int module) const
+{
+	assert (module >= 0 && module < getModulesCount ());
+	return m_modules[module].dependents;
+}
+
+//--------------------------------
+
+// Snapshot format, one record per line:
+//
+//     M <flags> <name>        module, numbered in order of appearance
+//     I <symbol>              import of the last module
+//     E <from> <to>           edge between module numbers
+
+bool DependencyGraph::save (const char* filename) const
+{
+	FILE* file = nullptr;
+	if (fopen_s (&file, filename, "w") || !file)
+	{
+		printf ("Warning: Failed to open '%s' for writing\n", filename);
+		return false;
+	}
+
+	bool ok = save (file);
+	fclose (file);
+
+	return ok;
+}
+
+// Writes the snapshot at the current position, so it can be embedded
+// in a larger file (traversal checkpoints)
+
+bool DependencyGraph::save (FILE* file) const
+{
+	fprintf (file, "%s\n", SnapshotSignature);
+
+	for (const Module& module: m_modules)
+	{
+		fprintf (file, "M %u %s\n", module.flags, module.name.c_str ());
+		if (module.imports)
+			for (const std::string& symbol: *module.imports)
+				fprintf (file, "I %s\n", symbol.c_str ());
+	}
+
+	for (int from = 0, count = getModulesCount (); from < count; from++)
+		for (int to: m_modules[from].dependencies)
+			fprintf (file, "E %d %d\n", from, to);
+
+	return !ferror (file);
+}
+
+//--------------------------------
+
+bool DependencyGraph::load (const char* filename)
+{
+	clear ();
+
+	FILE* file = nullptr;
+	if (fopen_s (&file, filename, "r") || !file)
+	{
+		printf ("Warning: Failed to open '%s' for reading\n", filename);
+		return false;
+	}
+
+	bool ok = load (file, filename);
+	fclose (file);
+
+	return ok;
+}
+
+// Reads a snapshot from the current position to the end of the file,
+// the filename is only used for messages
+
+bool DependencyGraph::load (FILE* file, const char* filename)
+{
+	clear ();
+
+	char line[SnapshotLineLength] = "";
+	if (!fgets (line, sizeof (line), file) || strncmp (line, SnapshotSignature, strlen (SnapshotSignature)) != 0)
+	{
+		printf ("Warning: '%s' is not a scan snapshot\n", filename);
+		return false;
+	}
+
+	// Imports are collected per module and handed over at the end
+	std::vector <std::vector <std::string>> imports;
+
+	bool ok = true;
+	while (ok && fgets (line, sizeof (line), file))
+	{
+		line[strcspn (line, "\r\n")] = '\0';
+
+		char*    rest  = nullptr;
+		unsigned flags = 0;
+		int      from  = 0;
+		int      to    = 0;
+
+		switch (line[0])
+		{
+			// Modules are numbered by their line, a name repeated in any case
+			// would fold into an earlier module and shift every number after it
+			case 'M':
+				flags = strtoul (line + 2, &rest, 10);
+				if (*rest != ' ' || findModule (rest + 1) != -1) ok = false;
+				else addFlags (addModule (rest + 1), flags);
+				break;
+
+			case 'I':
+				if (m_modules.empty ()) ok = false;
+				else
+				{
+					imports.resize (m_modules.size ());
+					imports.back ().push_back (line + 2);
+				}
+				break;
+
+			case 'E':
+				if (sscanf_s (line + 2, "%d %d", &from, &to) != 2 || from < 0 || to < 0 || from >= getModulesCount () || to >= getModulesCount ()) ok = false;
+				else addEdge (from, to);
+				break;
+
+			case '\0':
+				break;
+
+			default:
+				ok = false;
+		}
+	}
+
+	if (!ok)
+	{
+		printf ("Warning: Snapshot '%s' is corrupted: '%s'\n", filename, line);
+		clear ();
+		return false;
+	}
+
+	imports.resize (m_modules.size ());
+	for (size_t i = 0; i < m_modules.size (); i++)
+	{
+		std::sort (imports[i].begin (), imports[i].end ());
+		imports[i].erase (std::unique (imports[i].begin (), imports[i].end ()), imports[i].end ());
+
+		setImports ((int) i, std::make_shared <const std::vector <std::string>> (std::move (imports[i])));
+	}
+
+	return true;
+}
+
+//--------------------------------
+
+void DependencyGraph::clear ()
+{
+	m_modules.clear ();
+	m_index  .clear ();
+	m_edges  .clear ();
+}
+
+//--------------------------------
@@ -0,0 +1,93 @@
+#pragma once
+
+//--------------------------------
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+//--------------------------------
+
+// In-memory result of a scan: every module discovered by the crawl
+// and the import edges between them. Module names are matched
+// case-insensitively, the first spelling seen is kept for output.
+//
+// Each module also keeps its imported symbols as a sorted "module!function"
+// list together with a hash of that list, so two snapshots can tell an
+// unchanged module apart without comparing symbols one by one. The list
+// is shared, not copied: modules parsed from identical images point at
+// the one list of their cached summary.
+
+class DependencyGraph
+{
+public :
+	enum Flags
+	{
+		Root       = 1 << 0,
+		Missing    = 1 << 1,
+		SelfImport = 1 << 2,
+		Terminal   = 1 << 3,
+		Visited    = 1 << 4,
+		System     = 1 << 5,
+		Group      = 1 << 6,
+		Failed     = 1 << 7
+	};
+
+	typedef std::shared_ptr <const std::vector <std::string>> Imports;
+
+	DependencyGraph ();
+
+	int  addModule  (const char* name);
+	int  findModule (const char* name) const;
+	bool addEdge    (int from, int to);
+
+	void     addFlags (int module, unsigned flags);
+	unsigned getFlags (int module) const;
+
+	// Imports have to be sorted and without duplicates
+	void                             setImports     (int module, Imports imports);
+	const std::vector <std::string>& getImports     (int module) const;
+	uint64_t                         getImportsHash (int module) const;
+
+	int getModulesCount () const;
+	int getEdgesCount   () const;
+
+	const char*              getModuleName   (int module) const;
+	const std::vector <int>& getDependencies (int module) const;
+	const std::vector <int>& getDependents   (int module) const;
+
+	bool save (const char* filename) const;
+	bool load (const char* filename);
+
+	bool save (FILE* file) const;
+	bool load (FILE* file, const char* filename);
+
+	void clear ();
+
+private :
+	struct Module
+	{
+		std::string               name;
+		unsigned                  flags;
+		std::vector <int>         dependencies;
+		std::vector <int>         dependents;
+		Imports                   imports;
+		uint64_t                  imports_hash;
+	};
+
+	std::vector        <Module>           m_modules;
+	std::unordered_map <std::string, int> m_index;
+	std::unordered_set <uint64_t>         m_edges;
+
+	static const std::vector <std::string> NoImports;
+
+	static std::string MakeKey     (const char* name);
+	static uint64_t    HashImports (const std::vector <std::string>& imports);
+
+};
+
+//--------------------------------
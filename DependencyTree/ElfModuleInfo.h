@@ -0,0 +1,752 @@
+#pragma once
+
+//---------------------
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+//---------------------
+
+// ELF structures and constants, there is no <elf.h> on Windows. Only
+// little-endian files are supported, in both classes.
+
+namespace Elf
+{
+	const uint8_t ClassElf32 = 1;
+	const uint8_t ClassElf64 = 2;
+	const uint8_t DataLittle = 1;
+
+	const uint32_t ProgramLoad    = 1;
+	const uint32_t ProgramDynamic = 2;
+
+	const int64_t DynamicNull    = 0;
+	const int64_t DynamicNeeded  = 1;
+	const int64_t DynamicHash    = 4;
+	const int64_t DynamicStrTab  = 5;
+	const int64_t DynamicSymTab  = 6;
+	const int64_t DynamicStrSize = 10;
+	const int64_t DynamicSymEnt  = 11;
+	const int64_t DynamicSoname  = 14;
+	const int64_t DynamicRpath   = 15;
+	const int64_t DynamicRunpath = 29;
+	const int64_t DynamicGnuHash = 0x6FFFFEF5;
+
+	const uint8_t BindGlobal = 1;
+	const uint8_t BindWeak   = 2;
+	const uint8_t BindUnique = 10;
+
+	const uint8_t TypeSection = 3;
+	const uint8_t TypeFile    = 4;
+
+	const uint16_t SectionUndefined = 0;
+	const uint16_t SectionAbsolute  = 0xFFF1;
+
+	struct Header32
+	{
+		uint8_t  ident[16];
+		uint16_t type;
+		uint16_t machine;
+		uint32_t version;
+		uint32_t entry;
+		uint32_t phoff;
+		uint32_t shoff;
+		uint32_t flags;
+		uint16_t ehsize;
+		uint16_t phentsize;
+		uint16_t phnum;
+		uint16_t shentsize;
+		uint16_t shnum;
+		uint16_t shstrndx;
+	};
+
+	struct Header64
+	{
+		uint8_t  ident[16];
+		uint16_t type;
+		uint16_t machine;
+		uint32_t version;
+		uint64_t entry;
+		uint64_t phoff;
+		uint64_t shoff;
+		uint32_t flags;
+		uint16_t ehsize;
+		uint16_t phentsize;
+		uint16_t phnum;
+		uint16_t shentsize;
+		uint16_t shnum;
+		uint16_t shstrndx;
+	};
+
+	struct Program32
+	{
+		uint32_t type;
+		uint32_t offset;
+		uint32_t vaddr;
+		uint32_t paddr;
+		uint32_t filesz;
+		uint32_t memsz;
+		uint32_t flags;
+		uint32_t align;
+	};
+
+	struct Program64
+	{
+		uint32_t type;
+		uint32_t flags;
+		uint64_t offset;
+		uint64_t vaddr;
+		uint64_t paddr;
+		uint64_t filesz;
+		uint64_t memsz;
+		uint64_t align;
+	};
+
+	struct Dynamic32
+	{
+		int32_t  tag;
+		uint32_t value;
+	};
+
+	struct Dynamic64
+	{
+		int64_t  tag;
+		uint64_t value;
+	};
+
+	struct Symbol32
+	{
+		uint32_t name;
+		uint32_t value;
+		uint32_t size;
+		uint8_t  info;
+		uint8_t  other;
+		uint16_t shndx;
+	};
+
+	struct Symbol64
+	{
+		uint32_t name;
+		uint8_t  info;
+		uint8_t  other;
+		uint16_t shndx;
+		uint64_t value;
+		uint64_t size;
+	};
+}
+
+//---------------------
+
+// ELF counterpart of ModuleInfo, reading a shared object or executable
+// from a mapped file. Imported modules are the DT_NEEDED entries, the
+// symbols are the dynamic symbol table; ELF imports are not bound to a
+// module, so imported symbols are listed for the whole file.
+
+class ElfModuleInfo: public BasicModuleInfo
+{
+public:
+	ElfModuleInfo ();
+	ElfModuleInfo (const void* data, size_t size);
+
+	bool load (const void* data, size_t size);
+
+	virtual bool ok () const;
+
+	static bool IsElf (const void* data, size_t size);
+
+	bool is64 () const;
+
+	const char* getSoname  ();
+	const char* getRunPath ();
+
+	int         getImportModulesCount ();
+	const char* getImportModuleName   (int         index);
+	int         getImportModuleIndex  (const char* name );
+
+	int         getSymbolsCount  ();
+	const char* getSymbolName    (int index);
+	bool        isSymbolExported (int index);
+	bool        isSymbolImported (int index);
+
+	int getExportFunctionIndex (const char* name);
+
+protected:
+	struct Segment
+	{
+		uint64_t vaddr;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct Symbol
+	{
+		uint32_t name;
+		uint8_t  info;
+		uint16_t shndx;
+	};
+
+	const uint8_t*         m_data;
+	size_t                 m_size;
+	bool                   m_64;
+	std::vector <Segment>  m_segments;
+	std::vector <uint64_t> m_needed;
+	uint64_t               m_soname;
+	uint64_t               m_rpath;
+	uint64_t               m_runpath;
+
+	const char*    m_strings;
+	uint64_t       m_strings_size;
+	const uint8_t* m_symbols;
+	uint64_t       m_symbol_size;
+	int            m_symbols_count;
+
+	uint32_t        m_gnu_buckets_count;
+	uint32_t        m_gnu_symoffset;
+	uint32_t        m_gnu_bloom_size;
+	uint32_t        m_gnu_bloom_shift;
+	const uint8_t*  m_gnu_bloom;
+	const uint32_t* m_gnu_buckets;
+	const uint32_t* m_gnu_chain;
+
+	uint32_t        m_hash_buckets_count;
+	const uint32_t* m_hash_buckets;
+	const uint32_t* m_hash_chain;
+
+	template <typename header_t, typename program_t, typename dynamic_t, typename symbol_t> bool loadClass ();
+
+	const uint8_t* address   (uint64_t vaddr, uint64_t size);
+	const char*    string    (uint64_t offset);
+	Symbol         getSymbol (int index);
+
+	bool loadHash    (uint64_t hash, uint64_t gnu_hash);
+	int  countSymbols ();
+
+	static uint32_t GnuHash (const char* name);
+	static uint32_t ElfHash (const char* name);
+
+	static const uint64_t NoString = UINT64_MAX;
+
+};
+
+//---------------------
+
+inline ElfModuleInfo::ElfModuleInfo ():
+	BasicModuleInfo      (),
+	m_data               (nullptr),
+	m_size               (0),
+	m_64                 (false),
+	m_segments           (),
+	m_needed             (),
+	m_soname             (NoString),
+	m_rpath              (NoString),
+	m_runpath            (NoString),
+	m_strings            (nullptr),
+	m_strings_size       (0),
+	m_symbols            (nullptr),
+	m_symbol_size        (0),
+	m_symbols_count      (0),
+	m_gnu_buckets_count  (0),
+	m_gnu_symoffset      (0),
+	m_gnu_bloom_size     (0),
+	m_gnu_bloom_shift    (0),
+	m_gnu_bloom          (nullptr),
+	m_gnu_buckets        (nullptr),
+	m_gnu_chain          (nullptr),
+	m_hash_buckets_count (0),
+	m_hash_buckets       (nullptr),
+	m_hash_chain         (nullptr)
+{}
+
+inline ElfModuleInfo::ElfModuleInfo (const void* data, size_t size):
+	ElfModuleInfo ()
+{
+	load (data, size);
+}
+
+//---------------------
+
+inline bool ElfModuleInfo::IsElf (const void* data, size_t size)
+{
+	return size >= 4 && memcmp (data, "\x7F" "ELF", 4) == 0;
+}
+
+//---------------------
+
+inline bool ElfModuleInfo::load (const void* data, size_t size)
+{
+	*this = ElfModuleInfo ();
+
+	if (!IsElf (data, size) || size < sizeof (Elf::Header32))
+	{
+		formatError ("Failed to load module info: Not an ELF file");
+		return false;
+	}
+
+	m_data = (const uint8_t*) data;
+	m_size = size;
+	m_64   = m_data[4] == Elf::ClassElf64;
+
+	if (m_data[5] != Elf::DataLittle)
+	{
+		formatError ("Failed to load module info: Big-endian ELF files are not supported");
+		m_data = nullptr;
+		return false;
+	}
+
+	bool loaded = false;
+	if      (m_data[4] == Elf::ClassElf32) loaded = loadClass <Elf::Header32, Elf::Program32, Elf::Dynamic32, Elf::Symbol32> ();
+	else if (m_data[4] == Elf::ClassElf64) loaded = loadClass <Elf::Header64, Elf::Program64, Elf::Dynamic64, Elf::Symbol64> ();
+
+	else formatError ("Failed to load module info: Unknown ELF class (%d)", m_data[4]);
+
+	if (!loaded)
+		m_data = nullptr;
+
+	return loaded;
+}
+
+//---------------------
+
+template <typename header_t, typename program_t, typename dynamic_t, typename symbol_t>
+bool ElfModuleInfo::loadClass ()
+{
+	if (m_size < sizeof (header_t))
+	{
+		formatError ("Failed to load module info: ELF header is truncated");
+		return false;
+	}
+
+	const header_t* header = (const header_t*) m_data;
+	if (header -> phnum && (header -> phentsize != sizeof (program_t) || header -> phoff % alignof (program_t) || header -> phoff > m_size || (m_size - header -> phoff) / sizeof (program_t) < header -> phnum))
+	{
+		formatError ("Failed to load module info: Program headers are out of the file");
+		return false;
+	}
+
+	const program_t* programs = (const program_t*) (m_data + header -> phoff);
+	const program_t* dynamic  = nullptr;
+
+	for (int i = 0; i < header -> phnum; i++)
+	{
+		if (programs[i].type == Elf::ProgramLoad)
+			m_segments.push_back ({programs[i].vaddr, programs[i].offset, programs[i].filesz});
+
+		else if (programs[i].type == Elf::ProgramDynamic)
+			dynamic = &programs[i];
+	}
+
+	// Statically linked, nothing is imported or exported dynamically
+	if (!dynamic)
+		return true;
+
+	if (dynamic -> offset % alignof (dynamic_t) || dynamic -> offset > m_size || m_size - dynamic -> offset < dynamic -> filesz)
+	{
+		formatError ("Failed to load module info: Dynamic section is out of the file");
+		return false;
+	}
+
+	uint64_t strtab   = 0;
+	uint64_t symtab   = 0;
+	uint64_t hash     = 0;
+	uint64_t gnu_hash = 0;
+
+	m_symbol_size = sizeof (symbol_t);
+
+	const dynamic_t* entries = (const dynamic_t*) (m_data + dynamic -> offset);
+	for (size_t i = 0, count = dynamic -> filesz / sizeof (dynamic_t); i < count && entries[i].tag != Elf::DynamicNull; i++)
+	{
+		switch (entries[i].tag)
+		{
+			case Elf::DynamicNeeded:  m_needed.push_back (entries[i].value); break;
+			case Elf::DynamicSoname:  m_soname       = entries[i].value;     break;
+			case Elf::DynamicRpath:   m_rpath        = entries[i].value;     break;
+			case Elf::DynamicRunpath: m_runpath      = entries[i].value;     break;
+			case Elf::DynamicStrTab:  strtab         = entries[i].value;     break;
+			case Elf::DynamicStrSize: m_strings_size = entries[i].value;     break;
+			case Elf::DynamicSymTab:  symtab         = entries[i].value;     break;
+			case Elf::DynamicSymEnt:  m_symbol_size  = entries[i].value;     break;
+			case Elf::DynamicHash:    hash           = entries[i].value;     break;
+			case Elf::DynamicGnuHash: gnu_hash       = entries[i].value;     break;
+			default: break;
+		}
+	}
+
+	m_strings = (const char*) address (strtab, m_strings_size);
+	if (!m_strings)
+	{
+		formatError ("Failed to load module info: Dynamic string table is out of the file");
+		return false;
+	}
+
+	if (m_symbol_size < sizeof (symbol_t) || m_symbol_size % alignof (symbol_t))
+	{
+		formatError ("Failed to load module info: Wrong dynamic symbol size (%d)", (int) m_symbol_size);
+		return false;
+	}
+
+	if (!symtab || !loadHash (hash, gnu_hash))
+		return !hasError ();
+
+	m_symbols = address (symtab, m_symbols_count * m_symbol_size);
+	if (!m_symbols || (uintptr_t) m_symbols % alignof (symbol_t))
+	{
+		formatError ("Failed to load module info: Dynamic symbol table is out of the file");
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------
+
+inline bool ElfModuleInfo::ok () const
+{
+	return !m_has_error && m_data;
+}
+
+inline bool ElfModuleInfo::is64 () const
+{
+	return m_64;
+}
+
+//---------------------
+
+// Translates a virtual address to the file through the loadable segments,
+// nullptr unless the whole range is backed by the file
+
+inline const uint8_t* ElfModuleInfo::address (uint64_t vaddr, uint64_t size)
+{
+	for (const Segment& segment: m_segments)
+	{
+		if (vaddr < segment.vaddr || vaddr - segment.vaddr > segment.size || segment.size - (vaddr - segment.vaddr) < size) continue;
+
+		uint64_t offset = segment.offset + (vaddr - segment.vaddr);
+		if (offset > m_size || m_size - offset < size) return nullptr;
+
+		return m_data + offset;
+	}
+
+	return nullptr;
+}
+
+inline const char* ElfModuleInfo::string (uint64_t offset)
+{
+	if (!m_strings || offset >= m_strings_size)
+		return nullptr;
+
+	if (!memchr (m_strings + offset, '\0', (size_t) (m_strings_size - offset)))
+		return nullptr;
+
+	return m_strings + offset;
+}
+
+//---------------------
+
+inline const char* ElfModuleInfo::getSoname ()
+{
+	return m_soname == NoString? nullptr: string (m_soname);
+}
+
+// DT_RUNPATH takes precedence, DT_RPATH is ignored when both are present
+
+inline const char* ElfModuleInfo::getRunPath ()
+{
+	if (m_runpath != NoString) return string (m_runpath);
+	if (m_rpath   != NoString) return string (m_rpath);
+
+	return nullptr;
+}
+
+//---------------------
+
+inline int ElfModuleInfo::getImportModulesCount ()
+{
+	return (int) m_needed.size ();
+}
+
+inline const char* ElfModuleInfo::getImportModuleName (int index)
+{
+	if (index < 0 || index >= getImportModulesCount ())
+	{
+		formatError ("Failed to get import module name: Index out of range");
+		return nullptr;
+	}
+
+	const char* name = string (m_needed[index]);
+	if (!name)
+		formatError ("Failed to get import module name: Name is out of the string table");
+
+	return name;
+}
+
+inline int ElfModuleInfo::getImportModuleIndex (const char* name)
+{
+	for (int i = 0, count = getImportModulesCount (); i < count; i++)
+	{
+		const char* needed = getImportModuleName (i);
+		if (needed && !strcmp (needed, name)) return i;
+	}
+
+	return -1;
+}
+
+//---------------------
+
+/*
+
+	GNU hash section:
+
+	+================================+
+	| uint32 buckets_count           |
+	| uint32 symoffset               |  first symbol covered by the hash
+	| uint32 bloom_size              |
+	| uint32 bloom_shift             |
+	| addr   bloom  [bloom_size]     |  32 or 64 bit words, by class
+	| uint32 buckets[buckets_count]  |  first symbol of each bucket
+	| uint32 chain  [...]            |  hash of each symbol, lowest bit
+	+================================+  set on the last one of a bucket
+
+*/
+
+inline bool ElfModuleInfo::loadHash (uint64_t hash, uint64_t gnu_hash)
+{
+	if (gnu_hash)
+	{
+		const uint32_t* table = (const uint32_t*) address (gnu_hash, 4 * sizeof (uint32_t));
+		if (!table || (uintptr_t) table % alignof (uint32_t) || !table[0])
+		{
+			formatError ("Failed to load module info: GNU hash table is out of the file");
+			return false;
+		}
+
+		uint64_t word = m_64? 8: 4;
+
+		m_gnu_buckets_count = table[0];
+		m_gnu_symoffset     = table[1];
+		m_gnu_bloom_size    = table[2];
+		m_gnu_bloom_shift   = table[3];
+
+		m_gnu_bloom   =                    address (gnu_hash + 16,                                   m_gnu_bloom_size * word);
+		m_gnu_buckets = (const uint32_t*)  address (gnu_hash + 16 + m_gnu_bloom_size * word,         m_gnu_buckets_count * 4ull);
+		m_gnu_chain   = (const uint32_t*)  address (gnu_hash + 16 + m_gnu_bloom_size * word + m_gnu_buckets_count * 4ull, 0);
+
+		if (!m_gnu_bloom_size || m_gnu_bloom_shift >= 32 || !m_gnu_bloom || !m_gnu_buckets || !m_gnu_chain)
+		{
+			formatError ("Failed to load module info: GNU hash table is out of the file");
+			return false;
+		}
+	}
+
+	else if (hash)
+	{
+		const uint32_t* table = (const uint32_t*) address (hash, 2 * sizeof (uint32_t));
+		if (!table || (uintptr_t) table % alignof (uint32_t))
+		{
+			formatError ("Failed to load module info: Hash table is out of the file");
+			return false;
+		}
+
+		// nbucket, nchain, then the buckets and a chain link per symbol
+		m_hash_buckets_count = table[0];
+		m_hash_buckets       = (const uint32_t*) address (hash + 8, (table[0] + (uint64_t) table[1]) * 4);
+		m_hash_chain         = m_hash_buckets? m_hash_buckets + table[0]: nullptr;
+
+		if (!m_hash_buckets_count || !m_hash_buckets)
+		{
+			formatError ("Failed to load module info: Hash table is out of the file");
+			return false;
+		}
+
+		m_symbols_count = (int) table[1];
+		return true;
+	}
+
+	m_symbols_count = countSymbols ();
+	return m_symbols_count >= 0;
+}
+
+// Without DT_HASH the number of dynamic symbols is only known from the
+// GNU hash: it ends with the last chain of the highest bucket
+
+inline int ElfModuleInfo::countSymbols ()
+{
+	if (!m_gnu_buckets)
+		return 0;
+
+	uint32_t last = 0;
+	for (uint32_t i = 0; i < m_gnu_buckets_count; i++)
+		last = last > m_gnu_buckets[i]? last: m_gnu_buckets[i];
+
+	if (last < m_gnu_symoffset)
+		return (int) m_gnu_symoffset;
+
+	const uint8_t* end = m_data + m_size;
+	for (const uint32_t* link = m_gnu_chain + (last - m_gnu_symoffset);; link++, last++)
+	{
+		if ((const uint8_t*) (link + 1) > end)
+		{
+			formatError ("Failed to load module info: GNU hash chain is out of the file");
+			return -1;
+		}
+
+		if (*link & 1) break;
+	}
+
+	return (int) last + 1;
+}
+
+//---------------------
+
+inline ElfModuleInfo::Symbol ElfModuleInfo::getSymbol (int index)
+{
+	const uint8_t* entry = m_symbols + index * m_symbol_size;
+
+	if (m_64)
+	{
+		const Elf::Symbol64* symbol = (const Elf::Symbol64*) entry;
+		return {symbol -> name, symbol -> info, symbol -> shndx};
+	}
+
+	const Elf::Symbol32* symbol = (const Elf::Symbol32*) entry;
+	return {symbol -> name, symbol -> info, symbol -> shndx};
+}
+
+inline int ElfModuleInfo::getSymbolsCount ()
+{
+	return m_symbols? m_symbols_count: 0;
+}
+
+inline const char* ElfModuleInfo::getSymbolName (int index)
+{
+	if (index < 0 || index >= getSymbolsCount ())
+	{
+		formatError ("Failed to get symbol name: Index out of range");
+		return nullptr;
+	}
+
+	return string (getSymbol (index).name);
+}
+
+//---------------------
+
+inline bool ElfModuleInfo::isSymbolExported (int index)
+{
+	if (index < 0 || index >= getSymbolsCount ())
+		return false;
+
+	Symbol  symbol  = getSymbol (index);
+	uint8_t binding = symbol.info >> 4;
+	uint8_t type    = symbol.info & 0xF;
+
+	// Absolute symbols are the names of symbol versions, not something
+	// another module binds to
+	bool visible = binding == Elf::BindGlobal || binding == Elf::BindWeak || binding == Elf::BindUnique;
+	bool defined = symbol.shndx != Elf::SectionUndefined && symbol.shndx != Elf::SectionAbsolute;
+
+	return visible && defined && type != Elf::TypeSection && type != Elf::TypeFile && symbol.name;
+}
+
+inline bool ElfModuleInfo::isSymbolImported (int index)
+{
+	if (index < 0 || index >= getSymbolsCount ())
+		return false;
+
+	Symbol  symbol  = getSymbol (index);
+	uint8_t binding = symbol.info >> 4;
+
+	return (binding == Elf::BindGlobal || binding == Elf::BindWeak) && symbol.shndx == Elf::SectionUndefined && symbol.name;
+}
+
+//---------------------
+
+inline uint32_t ElfModuleInfo::GnuHash (const char* name)
+{
+	uint32_t hash = 5381;
+	for (; *name; name++)
+		hash = hash * 33 + (uint8_t) *name;
+
+	return hash;
+}
+
+// ELF hash of the DT_HASH table
+
+inline uint32_t ElfModuleInfo::ElfHash (const char* name)
+{
+	uint32_t hash = 0;
+	for (; *name; name++)
+	{
+		hash = (hash << 4) + (uint8_t) *name;
+		hash ^= (hash & 0xF0000000) >> 24;
+		hash &= 0x0FFFFFFF;
+	}
+
+	return hash;
+}
+
+// Looks the symbol up through the GNU hash when there is one: the bloom
+// filter rejects most misses, then a single bucket chain is walked.
+// Falls back to the DT_HASH chains, then to a scan of the symbol table.
+// Returns the dynamic symbol index of the definition or -1.
+
+inline int ElfModuleInfo::getExportFunctionIndex (const char* name)
+{
+	int count = getSymbolsCount ();
+
+	if (!m_gnu_buckets && m_hash_buckets && count)
+	{
+		// Every link is a symbol index, a broken table could loop forever
+		uint32_t index = m_hash_buckets[ElfHash (name) % m_hash_buckets_count];
+		for (int steps = 0; index && (int) index < count && steps < count; index = m_hash_chain[index], steps++)
+		{
+			const char* symbol = getSymbolName (index);
+			if (symbol && isSymbolExported (index) && !strcmp (symbol, name)) return (int) index;
+		}
+
+		return -1;
+	}
+
+	if (!m_gnu_buckets)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const char* symbol = getSymbolName (i);
+			if (symbol && isSymbolExported (i) && !strcmp (symbol, name)) return i;
+		}
+
+		return -1;
+	}
+
+	uint32_t hash = GnuHash (name);
+	uint32_t bits = m_64? 64: 32;
+
+	uint64_t word = 0;
+	memcpy (&word, m_gnu_bloom + (hash / bits % m_gnu_bloom_size) * (bits / 8), bits / 8);
+
+	uint64_t mask = (1ull << (hash % bits)) | (1ull << ((hash >> m_gnu_bloom_shift) % bits));
+	if ((word & mask) != mask)
+		return -1;
+
+	uint32_t index = m_gnu_buckets[hash % m_gnu_buckets_count];
+	if (index < m_gnu_symoffset)
+		return -1;
+
+	for (; (int) index < count; index++)
+	{
+		const uint32_t* link = m_gnu_chain + (index - m_gnu_symoffset);
+		if ((const uint8_t*) (link + 1) > m_data + m_size) break;
+
+		uint32_t chain = *link;
+
+		if ((chain | 1) == (hash | 1))
+		{
+			const char* symbol = getSymbolName (index);
+			if (symbol && isSymbolExported (index) && !strcmp (symbol, name)) return (int) index;
+		}
+
+		if (chain & 1) break;
+	}
+
+	return -1;
+}
+
+//---------------------
@@ -0,0 +1,574 @@
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+#include <Windows.h>
+#include "BasicModuleInfo.h"
+#include "ExportDatabase.h"
+
+//--------------------------------
+
+static const char     DatabaseSignature[8] = {'D', 'T', 'E', 'X', 'P', 'D', 'B', '1'};
+static const uint32_t NoSlot               = UINT32_MAX;
+static const uint32_t SaltAttempts         = 16;
+
+//--------------------------------
+
+namespace
+{
+	uint64_t Mix (uint64_t value)
+	{
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ull;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBull;
+		value ^= value >> 31;
+
+		return value;
+	}
+
+	void PutVarint (std::vector <uint8_t>* out, uint32_t value)
+	{
+		for (; value >= 0x80; value >>= 7)
+			out -> push_back ((uint8_t) (value | 0x80));
+
+		out -> push_back ((uint8_t) value);
+	}
+
+	bool GetVarint (const uint8_t** data, const uint8_t* end, uint32_t* value)
+	{
+		*value = 0;
+		for (int shift = 0; *data < end && shift < 32; shift += 7)
+		{
+			uint8_t byte = *(*data)++;
+			*value |= (uint32_t) (byte & 0x7F) << shift;
+
+			if (!(byte & 0x80)) return true;
+		}
+
+		return false;
+	}
+
+	uint64_t Align (uint64_t offset)
+	{
+		return (offset + 3) & ~3ull;
+	}
+}
+
+//--------------------------------
+
+ExportDatabase::ExportDatabase ():
+	m_view           (nullptr),
+	m_header         (nullptr),
+	m_block_offsets  (nullptr),
+	m_strings        (nullptr),
+	m_seeds          (nullptr),
+	m_slots          (nullptr),
+	m_postings_index (nullptr),
+	m_postings       (nullptr),
+	m_modules        (nullptr),
+	m_names          (nullptr)
+{}
+
+ExportDatabase::~ExportDatabase ()
+{
+	close ();
+}
+
+//--------------------------------
+
+uint64_t ExportDatabase::HashSymbol (const char* symbol, uint32_t salt)
+{
+	uint64_t hash = 0xCBF29CE484222325ull ^ Mix (salt);
+	for (; *symbol; symbol++)
+	{
+		hash ^= (unsigned char) *symbol;
+		hash *= 0x00000100000001B3ull;
+	}
+
+	return Mix (hash);
+}
+
+uint32_t ExportDatabase::Slot (uint64_t hash, uint32_t seed, uint32_t slots_count)
+{
+	return (uint32_t) (Mix (hash + (seed + 1ull) * 0x9E3779B97F4A7C15ull) % slots_count);
+}
+
+//--------------------------------
+
+bool ExportDatabase::open (const char* filename)
+{
+	close ();
+
+	HANDLE file = CreateFileA (filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		printf ("Warning: Failed to open '%s': %s\n", filename, FormatWinapiError (GetLastError ()));
+		return false;
+	}
+
+	LARGE_INTEGER size = {};
+	GetFileSizeEx (file, &size);
+
+	// The view keeps the mapping and the file referenced on its own
+	HANDLE mapping = size.QuadPart? CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr): nullptr;
+	CloseHandle (file);
+
+	m_view = mapping? (const char*) MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0): nullptr;
+	if (mapping)
+		CloseHandle (mapping);
+
+	if (!m_view)
+	{
+		printf ("Warning: Failed to map '%s': %s\n", filename, FormatWinapiError (GetLastError ()));
+		return false;
+	}
+
+	m_header = (const Header*) m_view;
+	if (!validate ((uint64_t) size.QuadPart))
+	{
+		printf ("Warning: '%s' is not a valid export database\n", filename);
+		close ();
+		return false;
+	}
+
+	m_block_offsets  = (const uint32_t*) (m_view + m_header -> block_offsets );
+	m_strings        = (const uint8_t* ) (m_view + m_header -> strings       );
+	m_seeds          = (const uint32_t*) (m_view + m_header -> seeds         );
+	m_slots          = (const uint32_t*) (m_view + m_header -> slots         );
+	m_postings_index = (const uint32_t*) (m_view + m_header -> postings_index);
+	m_postings       = (const Posting* ) (m_view + m_header -> postings      );
+	m_modules        = (const uint32_t*) (m_view + m_header -> modules       );
+	m_names          =                    m_view + m_header -> names;
+
+	return true;
+}
+
+void ExportDatabase::close ()
+{
+	if (m_view)
+		UnmapViewOfFile (m_view);
+
+	m_view           = nullptr;
+	m_header         = nullptr;
+	m_block_offsets  = nullptr;
+	m_strings        = nullptr;
+	m_seeds          = nullptr;
+	m_slots          = nullptr;
+	m_postings_index = nullptr;
+	m_postings       = nullptr;
+	m_modules        = nullptr;
+	m_names          = nullptr;
+}
+
+//--------------------------------
+
+// Checks that every section lies inside the file, the contents of the
+// sections themselves are checked where they are used
+
+bool ExportDatabase::validate (uint64_t size) const
+{
+	if (size < sizeof (Header) || memcmp (m_header -> signature, DatabaseSignature, sizeof (DatabaseSignature)) != 0)
+		return false;
+
+	const Header& header = *m_header;
+
+	uint64_t symbols = header.symbols_count;
+	uint64_t blocks  = (symbols + BlockSize - 1) / BlockSize;
+
+	bool ok = header.size == size && header.blocks_count == blocks && (header.buckets_count || !symbols);
+
+	auto fits = [size] (uint64_t offset, uint64_t length) { return offset % 4 == 0 && offset + length <= size; };
+
+	ok = ok && fits (header.block_offsets,  (blocks + 1)                    * sizeof (uint32_t));
+	ok = ok && fits (header.seeds,          (uint64_t) header.buckets_count * sizeof (uint32_t));
+	ok = ok && fits (header.slots,          symbols                         * sizeof (uint32_t));
+	ok = ok && fits (header.postings_index, (symbols + 1)                   * sizeof (uint32_t));
+	ok = ok && fits (header.modules,        (uint64_t) header.modules_count * sizeof (uint32_t));
+	ok = ok && header.strings <= size && header.names < size && m_view[size - 1] == '\0';
+
+	if (!ok)
+		return false;
+
+	// Blocks and posting lists are read from one offset to the next, the
+	// offsets can't go backwards
+	const uint32_t* block_offsets  = (const uint32_t*) (m_view + header.block_offsets );
+	const uint32_t* postings_index = (const uint32_t*) (m_view + header.postings_index);
+
+	for (uint64_t i = 0; i < blocks; i++)
+		if (block_offsets[i] > block_offsets[i + 1]) return false;
+
+	for (uint64_t i = 0; i < symbols; i++)
+		if (postings_index[i] > postings_index[i + 1]) return false;
+
+	return header.strings + (uint64_t) block_offsets[blocks] <= size && fits (header.postings, postings_index[symbols] * (uint64_t) sizeof (Posting));
+}
+
+//--------------------------------
+
+int ExportDatabase::getSymbolsCount () const
+{
+	return m_header? (int) m_header -> symbols_count: 0;
+}
+
+int ExportDatabase::getModulesCount () const
+{
+	return m_header? (int) m_header -> modules_count: 0;
+}
+
+//--------------------------------
+
+std::string ExportDatabase::getSymbol (int symbol) const
+{
+	if (symbol < 0 || symbol >= getSymbolsCount ())
+		return "";
+
+	// A corrupted block reads as an empty symbol, never past its end
+	const uint8_t* data = m_strings + m_block_offsets[symbol / BlockSize];
+	const uint8_t* end  = m_strings + m_block_offsets[symbol / BlockSize + 1];
+
+	uint32_t length = 0;
+	if (!GetVarint (&data, end, &length) || length > (size_t) (end - data))
+		return "";
+
+	std::string result ((const char*) data, length);
+	data += length;
+
+	for (int i = 0; i < (int) (symbol % BlockSize); i++)
+	{
+		uint32_t shared = 0;
+		uint32_t suffix = 0;
+
+		if (!GetVarint (&data, end, &shared) || !GetVarint (&data, end, &suffix) || suffix > (size_t) (end - data))
+			return "";
+
+		result.resize (std::min <size_t> (shared, result.size ()));
+		result.append ((const char*) data, suffix);
+		data += suffix;
+	}
+
+	return result;
+}
+
+//--------------------------------
+
+int ExportDatabase::find (const char* symbol) const
+{
+	if (!getSymbolsCount ())
+		return -1;
+
+	uint64_t hash = HashSymbol (symbol, m_header -> salt);
+	uint32_t seed = m_seeds[hash % m_header -> buckets_count];
+	uint32_t slot = Slot (hash, seed, m_header -> symbols_count);
+
+	int candidate = (int) m_slots[slot];
+	return getSymbol (candidate) == symbol? candidate: -1;
+}
+
+//--------------------------------
+
+std::vector <ExportDatabase::Export> ExportDatabase::getExports (int symbol) const
+{
+	std::vector <Export> exports;
+	if (symbol < 0 || symbol >= getSymbolsCount ())
+		return exports;
+
+	uint32_t names_size = m_header -> size - m_header -> names;
+
+	for (uint32_t i = m_postings_index[symbol]; i < m_postings_index[symbol + 1]; i++)
+	{
+		const Posting& posting = m_postings[i];
+		if (posting.module >= m_header -> modules_count || m_modules[posting.module] >= names_size || posting.forwarder >= names_size) continue;
+
+		exports.push_back ({m_names + m_modules[posting.module], (int) posting.ordinal, posting.forwarder? m_names + posting.forwarder: nullptr});
+	}
+
+	return exports;
+}
+
+//--------------------------------
+
+ExportDatabaseBuilder::ExportDatabaseBuilder ():
+	m_modules    (),
+	m_symbols    (),
+	m_names      (1, '\0'),
+	m_forwarders ()
+{}
+
+//--------------------------------
+
+int ExportDatabaseBuilder::getSymbolsCount () const
+{
+	return (int) m_symbols.size ();
+}
+
+int ExportDatabaseBuilder::getModulesCount () const
+{
+	return (int) m_modules.size ();
+}
+
+//--------------------------------
+
+// Offset 0 of the names section is an empty string, a posting with no
+// forwarder points there
+
+uint32_t ExportDatabaseBuilder::addName (const std::string& name)
+{
+	auto found = m_forwarders.find (name);
+	if (found != m_forwarders.end ())
+		return found -> second;
+
+	uint32_t offset = (uint32_t) m_names.size ();
+	m_names.append (name.c_str (), name.size () + 1);
+
+	m_forwarders.emplace (name, offset);
+	return offset;
+}
+
+void ExportDatabaseBuilder::add (const char* module, const ModuleSummary& summary)
+{
+	uint32_t index = (uint32_t) m_modules.size ();
+	m_modules.push_back (module);
+
+	for (const ModuleExport& entry: summary.exports)
+	{
+		uint32_t forwarder = entry.forwarder.empty ()? 0: addName (entry.forwarder);
+		m_symbols[entry.name].push_back ({index, (uint32_t) entry.ordinal, forwarder});
+	}
+}
+
+//--------------------------------
+
+// Hash and displace: symbols are spread over buckets of about four, and
+// each bucket, largest first, gets the first seed that sends all of its
+// symbols to free slots. With as many slots as symbols the hash is
+// minimal. The salt changes only if two symbols can't be told apart.
+
+bool ExportDatabaseBuilder::BuildHash (const std::vector <const std::string*>& symbols, uint32_t* salt, std::vector <uint32_t>* seeds, std::vector <uint32_t>* slots)
+{
+	uint32_t count   = (uint32_t) symbols.size ();
+	uint32_t buckets = std::max (1u, (count + 3) / 4);
+	uint64_t limit   = std::min <uint64_t> (64ull * count + 1024, UINT32_MAX);
+
+	std::vector <uint64_t>              hashes  (count);
+	std::vector <std::vector <uint32_t>> members (buckets);
+	std::vector <uint32_t>              order   (buckets);
+	std::vector <uint32_t>              taken;
+
+	for (*salt = 0; *salt < SaltAttempts; (*salt)++)
+	{
+		for (auto& bucket: members)
+			bucket.clear ();
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			hashes[i] = ExportDatabase::HashSymbol (symbols[i] -> c_str (), *salt);
+			members[hashes[i] % buckets].push_back (i);
+		}
+
+		for (uint32_t i = 0; i < buckets; i++)
+			order[i] = i;
+
+		std::stable_sort (order.begin (), order.end (), [&members] (uint32_t a, uint32_t b) { return members[a].size () > members[b].size (); });
+
+		seeds -> assign (buckets, 0);
+		slots -> assign (count, NoSlot);
+
+		bool ok = true;
+		for (uint32_t bucket: order)
+		{
+			if (members[bucket].empty ()) break;
+
+			uint64_t seed = 0;
+			for (; seed < limit; seed++)
+			{
+				taken.clear ();
+				for (uint32_t symbol: members[bucket])
+				{
+					uint32_t slot = ExportDatabase::Slot (hashes[symbol], (uint32_t) seed, count);
+					if ((*slots)[slot] != NoSlot || std::find (taken.begin (), taken.end (), slot) != taken.end ()) break;
+
+					taken.push_back (slot);
+				}
+
+				if (taken.size () == members[bucket].size ()) break;
+			}
+
+			if (seed == limit)
+			{
+				ok = false;
+				break;
+			}
+
+			(*seeds)[bucket] = (uint32_t) seed;
+			for (size_t i = 0; i < taken.size (); i++)
+				(*slots)[taken[i]] = members[bucket][i];
+		}
+
+		if (ok) return true;
+	}
+
+	return false;
+}
+
+//--------------------------------
+
+bool ExportDatabaseBuilder::write (const char* filename) const
+{
+	std::vector <const std::string*> symbols;
+	symbols.reserve (m_symbols.size ());
+
+	for (const auto& symbol: m_symbols)
+		symbols.push_back (&symbol.first);
+
+	std::sort (symbols.begin (), symbols.end (), [] (const std::string* a, const std::string* b) { return *a < *b; });
+
+	uint32_t count = (uint32_t) symbols.size ();
+
+	// Front coding: the first symbol of a block is stored whole, the
+	// others as the length shared with the previous one plus the rest
+	std::vector <uint8_t>  strings;
+	std::vector <uint32_t> block_offsets;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const std::string& symbol = *symbols[i];
+
+		if (i % ExportDatabase::BlockSize == 0)
+		{
+			block_offsets.push_back ((uint32_t) strings.size ());
+			PutVarint (&strings, (uint32_t) symbol.size ());
+			strings.insert (strings.end (), symbol.begin (), symbol.end ());
+			continue;
+		}
+
+		const std::string& previous = *symbols[i - 1];
+
+		uint32_t shared = 0;
+		while (shared < previous.size () && shared < symbol.size () && previous[shared] == symbol[shared])
+			shared++;
+
+		PutVarint (&strings, shared);
+		PutVarint (&strings, (uint32_t) symbol.size () - shared);
+		strings.insert (strings.end (), symbol.begin () + shared, symbol.end ());
+	}
+
+	block_offsets.push_back ((uint32_t) strings.size ());
+
+	uint32_t               salt = 0;
+	std::vector <uint32_t> seeds;
+	std::vector <uint32_t> slots;
+
+	if (count && !BuildHash (symbols, &salt, &seeds, &slots))
+	{
+		printf ("Warning: Failed to build the symbol hash for '%s'\n", filename);
+		return false;
+	}
+
+	std::vector <uint32_t>                postings_index;
+	std::vector <ExportDatabase::Posting> postings;
+
+	for (const std::string* symbol: symbols)
+	{
+		const std::vector <ExportDatabase::Posting>& list = m_symbols.at (*symbol);
+
+		postings_index.push_back ((uint32_t) postings.size ());
+		postings.insert (postings.end (), list.begin (), list.end ());
+	}
+
+	postings_index.push_back ((uint32_t) postings.size ());
+
+	std::string            names = m_names;
+	std::vector <uint32_t> modules;
+
+	for (const std::string& module: m_modules)
+	{
+		modules.push_back ((uint32_t) names.size ());
+		names.append (module.c_str (), module.size () + 1);
+	}
+
+	ExportDatabase::Header header = {};
+	memcpy (header.signature, DatabaseSignature, sizeof (DatabaseSignature));
+
+	header.salt           = salt;
+	header.symbols_count  = count;
+	header.modules_count  = (uint32_t) m_modules.size ();
+	header.blocks_count   = (uint32_t) block_offsets.size () - 1;
+	header.buckets_count  = (uint32_t) seeds.size ();
+
+	// Laid out in 64 bits first, so that a corpus too large for the format
+	// fails here instead of wrapping around
+	uint64_t end   = sizeof (header);
+	auto     place = [&end] (uint64_t size)
+	{
+		uint64_t at = Align (end);
+		end = at + size;
+
+		return at;
+	};
+
+	uint64_t block_offsets_at  = place (block_offsets .size () * sizeof (uint32_t));
+	uint64_t strings_at        = place (strings       .size ());
+	uint64_t seeds_at          = place (seeds         .size () * sizeof (uint32_t));
+	uint64_t slots_at          = place (slots         .size () * sizeof (uint32_t));
+	uint64_t postings_index_at = place (postings_index.size () * sizeof (uint32_t));
+	uint64_t postings_at       = place (postings      .size () * sizeof (ExportDatabase::Posting));
+	uint64_t modules_at        = place (modules       .size () * sizeof (uint32_t));
+	uint64_t names_at          = place (names         .size ());
+
+	if (end > UINT32_MAX)
+	{
+		printf ("Warning: '%s' would take %llu MB, more than the 4 GB an export database can hold\n", filename, (unsigned long long) (end >> 20));
+		return false;
+	}
+
+	header.block_offsets  = (uint32_t) block_offsets_at;
+	header.strings        = (uint32_t) strings_at;
+	header.seeds          = (uint32_t) seeds_at;
+	header.slots          = (uint32_t) slots_at;
+	header.postings_index = (uint32_t) postings_index_at;
+	header.postings       = (uint32_t) postings_at;
+	header.modules        = (uint32_t) modules_at;
+	header.names          = (uint32_t) names_at;
+	header.size           = (uint32_t) end;
+
+	FILE* file = nullptr;
+	if (fopen_s (&file, filename, "wb") || !file)
+	{
+		printf ("Warning: Failed to open '%s' for writing\n", filename);
+		return false;
+	}
+
+	uint64_t offset = 0;
+	auto put = [file, &offset] (uint64_t at, const void* data, size_t size)
+	{
+		static const char padding[4] = {};
+
+		fwrite (padding, 1, (size_t) (at - offset), file);
+		if (size)
+			fwrite (data, 1, size, file);
+
+		offset = at + size;
+	};
+
+	put (0,                     &header,                 sizeof (header));
+	put (header.block_offsets,  block_offsets .data (), block_offsets .size () * sizeof (uint32_t));
+	put (header.strings,        strings       .data (), strings       .size ());
+	put (header.seeds,          seeds         .data (), seeds         .size () * sizeof (uint32_t));
+	put (header.slots,          slots         .data (), slots         .size () * sizeof (uint32_t));
+	put (header.postings_index, postings_index.data (), postings_index.size () * sizeof (uint32_t));
+	put (header.postings,       postings      .data (), postings      .size () * sizeof (ExportDatabase::Posting));
+	put (header.modules,        modules       .data (), modules       .size () * sizeof (uint32_t));
+	put (header.names,          names         .data (), names         .size ());
+
+	bool ok = !ferror (file);
+	ok = fclose (file) == 0 && ok;
+
+	if (!ok)
+		printf ("Warning: Failed to write '%s'\n", filename);
+
+	return ok;
+}
+
+//--------------------------------
@@ -0,0 +1,136 @@
+#pragma once
+
+//--------------------------------
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "ImageCache.h"
+
+//--------------------------------
+
+// Read-only database of the named exports of a corpus of modules,
+// answering "which modules export this symbol" without loading any of
+// them. The file is opened with a single read-only mapping.
+//
+// Layout, all offsets from the start of the file:
+//
+//     Header
+//     block offsets   uint32 [blocks + 1]   into the strings section, ascending
+//     strings         sorted symbols, front-coded in blocks of BlockSize
+//     seeds           uint32 [buckets]      minimal perfect hash (CHD)
+//     slots           uint32 [symbols]      hash slot -> symbol id
+//     postings index  uint32 [symbols + 1]  into postings, ascending
+//     postings        Posting [...]         per symbol, by module
+//     modules         uint32 [modules]      into names
+//     names           zero terminated module names and forwarders
+//
+// A symbol id is its position in sorted order. Exact lookups hash the
+// symbol to its slot and check it against the decoded string, so a
+// lookup costs one hash and one block decode.
+//
+// Offsets are 32 bits, a database can't grow past 4 GB.
+
+class ExportDatabase
+{
+public :
+	struct Export
+	{
+		const char* module;
+		int         ordinal;
+		const char* forwarder;
+	};
+
+	ExportDatabase ();
+	~ExportDatabase ();
+
+	bool open  (const char* filename);
+	void close ();
+
+	int         find            (const char* symbol) const;
+	std::string getSymbol       (int symbol) const;
+	int         getSymbolsCount () const;
+	int         getModulesCount () const;
+
+	std::vector <Export> getExports (int symbol) const;
+
+	static const uint32_t BlockSize = 16;
+
+private :
+	friend class ExportDatabaseBuilder;
+
+	struct Header
+	{
+		char     signature[8];
+		uint32_t salt;
+		uint32_t symbols_count;
+		uint32_t modules_count;
+		uint32_t blocks_count;
+		uint32_t buckets_count;
+		uint32_t block_offsets;
+		uint32_t strings;
+		uint32_t seeds;
+		uint32_t slots;
+		uint32_t postings_index;
+		uint32_t postings;
+		uint32_t modules;
+		uint32_t names;
+		uint32_t size;
+	};
+
+	struct Posting
+	{
+		uint32_t module;
+		uint32_t ordinal;
+		uint32_t forwarder;
+	};
+
+	const char*     m_view;
+	const Header*   m_header;
+	const uint32_t* m_block_offsets;
+	const uint8_t*  m_strings;
+	const uint32_t* m_seeds;
+	const uint32_t* m_slots;
+	const uint32_t* m_postings_index;
+	const Posting*  m_postings;
+	const uint32_t* m_modules;
+	const char*     m_names;
+
+	bool validate (uint64_t size) const;
+
+	static uint64_t HashSymbol (const char* symbol, uint32_t salt);
+	static uint32_t Slot       (uint64_t hash, uint32_t seed, uint32_t slots_count);
+
+};
+
+//--------------------------------
+
+// Collects exports module by module and writes them out as an
+// ExportDatabase file.
+
+class ExportDatabaseBuilder
+{
+public :
+	ExportDatabaseBuilder ();
+
+	void add   (const char* module, const ModuleSummary& summary);
+	bool write (const char* filename) const;
+
+	int getSymbolsCount () const;
+	int getModulesCount () const;
+
+private :
+	std::vector        <std::string>                                        m_modules;
+	std::unordered_map <std::string, std::vector <ExportDatabase::Posting>> m_symbols;
+	std::string                                                             m_names;
+	std::unordered_map <std::string, uint32_t>                              m_forwarders;
+
+	uint32_t addName (const std::string& name);
+
+	static bool BuildHash (const std::vector <const std::string*>& symbols, uint32_t* salt, std::vector <uint32_t>* seeds, std::vector <uint32_t>* slots);
+
+};
+
+//--------------------------------
@@ -0,0 +1,326 @@
+#include <cstring>
+
+#include "Exporter.h"
+
+//--------------------------------
+
+static const struct
+{
+	unsigned    flag;
+	const char* name;
+}
+FlagNames[] =
+{
+	{DependencyGraph::Root,       "root"       },
+	{DependencyGraph::Missing,    "missing"    },
+	{DependencyGraph::SelfImport, "self-import"},
+	{DependencyGraph::Terminal,   "terminal"   },
+	{DependencyGraph::System,     "system"     },
+	{DependencyGraph::Group,      "group"      },
+	{DependencyGraph::Failed,     "failed"     }
+};
+
+//--------------------------------
+
+Exporter::~Exporter ()
+{}
+
+bool Exporter::ok () const
+{
+	return true;
+}
+
+//--------------------------------
+
+// Feeds an already finished graph through the exporter, for output
+// that is produced after the crawl (reduced or loaded scans).
+
+void Exporter::replay (const DependencyGraph& graph)
+{
+	for (int module = 0, count = graph.getModulesCount (); module < count; module++)
+		node (graph.getModuleName (module), graph.getFlags (module));
+
+	for (int from = 0, count = graph.getModulesCount (); from < count; from++)
+		for (int to: graph.getDependencies (from))
+			edge (graph.getModuleName (from), graph.getModuleName (to), graph.getFlags (to));
+}
+
+//--------------------------------
+
+Exporter* Exporter::Create (const char* format, const char* filename)
+{
+	Exporter* exporter = nullptr;
+
+	if      (!strcmp (format, "jsonl"  )) exporter = new JsonLinesExporter (filename);
+	else if (!strcmp (format, "graphml")) exporter = new GraphMLExporter   (filename);
+	else if (!strcmp (format, "csv"    )) exporter = new CsvExporter       (filename);
+
+	else
+	{
+		printf ("Warning: Unknown export format '%s'\n", format);
+		return nullptr;
+	}
+
+	if (!exporter -> ok ())
+	{
+		printf ("Warning: Failed to open '%s' for writing\n", filename);
+
+		delete exporter;
+		return nullptr;
+	}
+
+	return exporter;
+}
+
+//--------------------------------
+
+void TeeExporter::attach (Exporter* exporter)
+{
+	m_exporters.push_back (exporter);
+}
+
+void TeeExporter::node (const char* name, unsigned flags)
+{
+	for (Exporter* exporter: m_exporters)
+		exporter -> node (name, flags);
+}
+
+void TeeExporter::edge (const char* from, const char* to, unsigned flags)
+{
+	for (Exporter* exporter: m_exporters)
+		exporter -> edge (from, to, flags);
+}
+
+//--------------------------------
+
+DotExporter::DotExporter (Graph* graph):
+	m_graph (graph)
+{}
+
+void DotExporter::node (const char* name, unsigned flags)
+{
+	if (flags & (DependencyGraph::Missing | DependencyGraph::Failed))
+		m_graph -> node (name, {{"style", "filled"}, {"fillcolor", "\"#5E1B1B\""}}, Broken);
+
+	else if (flags & DependencyGraph::Terminal)
+		m_graph -> node (name, {{"style", "filled"}, {"fillcolor", "\"#13463C\""}}, Flagged);
+
+	else if (flags & DependencyGraph::Group)
+		m_graph -> node (name, {{"shape", "folder"}, {"style", "filled"}, {"fillcolor", "\"#303030\""}}, Flagged);
+
+	else if (flags & DependencyGraph::Root)
+		m_graph -> node (name, {{"style", "filled"}, {"fillcolor", "\"#12304D\""}}, Flagged);
+
+	else m_graph -> node (name);
+}
+
+void DotExporter::edge (const char* from, const char* to, unsigned flags)
+{
+	if (from == to || strcmp (from, to) == 0)
+	{
+		m_graph -> node (to, {{"style", "filled"}, {"fillcolor", "\"#464513\""}}, SelfImport);
+		m_graph -> edge (from, to, {{"color", "\"#FFFF00\""}, {"fillcolor", "\"#FFFF00\""}}, SelfImport);
+	}
+
+	else if (flags & (DependencyGraph::Missing | DependencyGraph::Failed))
+		m_graph -> edge (from, to, {{"color", "\"#5e1b1b\""}, {"fillcolor", "\"#FF0000\""}}, Broken);
+
+	else m_graph -> edge (from, to);
+}
+
+//--------------------------------
+
+FileExporter::FileExporter (const char* filename):
+	m_file (nullptr)
+{
+	fopen_s (&m_file, filename, "w");
+}
+
+FileExporter::~FileExporter ()
+{
+	if (m_file)
+		fclose (m_file);
+
+	m_file = nullptr;
+}
+
+bool FileExporter::ok () const
+{
+	return m_file != nullptr;
+}
+
+//--------------------------------
+
+void FileExporter::writeFlags (unsigned flags, char separator)
+{
+	bool first = true;
+	for (const auto& flag: FlagNames)
+	{
+		if (!(flags & flag.flag)) continue;
+
+		if (!first) fputc (separator, m_file);
+		fputs (flag.name, m_file);
+
+		first = false;
+	}
+}
+
+//--------------------------------
+
+JsonLinesExporter::JsonLinesExporter (const char* filename):
+	FileExporter (filename)
+{}
+
+void JsonLinesExporter::node (const char* name, unsigned flags)
+{
+	fputs ("{\"type\":\"node\",\"name\":", m_file);
+	writeString (name);
+	writeFlags  (flags);
+	fputs ("}\n", m_file);
+}
+
+void JsonLinesExporter::edge (const char* from, const char* to, unsigned flags)
+{
+	fputs ("{\"type\":\"edge\",\"from\":", m_file);
+	writeString (from);
+	fputs (",\"to\":", m_file);
+	writeString (to);
+	writeFlags  (flags);
+	fputs ("}\n", m_file);
+}
+
+// Edges carry the flags of their target, same as the node records
+
+void JsonLinesExporter::writeFlags (unsigned flags)
+{
+	fputs (",\"flags\":[", m_file);
+
+	bool first = true;
+	for (const auto& flag: FlagNames)
+	{
+		if (!(flags & flag.flag)) continue;
+
+		fprintf (m_file, "%s\"%s\"", first? "": ",", flag.name);
+		first = false;
+	}
+
+	fputc (']', m_file);
+}
+
+void JsonLinesExporter::writeString (const char* str)
+{
+	fputc ('"', m_file);
+
+	for (; *str; str++)
+	{
+		unsigned char c = (unsigned char) *str;
+
+		if      (c == '"' || c == '\\') fprintf (m_file, "\\%c", c);
+		else if (c < 0x20)              fprintf (m_file, "\\u%04X", c);
+		else                            fputc   (c, m_file);
+	}
+
+	fputc ('"', m_file);
+}
+
+//--------------------------------
+
+GraphMLExporter::GraphMLExporter (const char* filename):
+	FileExporter (filename)
+{
+	if (!m_file) return;
+
+	fputs ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", m_file);
+	fputs ("<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n", m_file);
+	fputs ("  <key id=\"flags\" for=\"node\" attr.name=\"flags\" attr.type=\"string\"/>\n", m_file);
+	fputs ("  <key id=\"target_flags\" for=\"edge\" attr.name=\"target_flags\" attr.type=\"string\"/>\n", m_file);
+	fputs ("  <graph id=\"dependencies\" edgedefault=\"directed\">\n", m_file);
+}
+
+GraphMLExporter::~GraphMLExporter ()
+{
+	if (!m_file) return;
+
+	fputs ("  </graph>\n", m_file);
+	fputs ("</graphml>\n", m_file);
+}
+
+void GraphMLExporter::node (const char* name, unsigned flags)
+{
+	fputs ("    <node id=\"", m_file);
+	writeString (name);
+	fputs ("\"><data key=\"flags\">", m_file);
+	writeFlags (flags, ' ');
+	fputs ("</data></node>\n", m_file);
+}
+
+void GraphMLExporter::edge (const char* from, const char* to, unsigned flags)
+{
+	fputs ("    <edge source=\"", m_file);
+	writeString (from);
+	fputs ("\" target=\"", m_file);
+	writeString (to);
+	fputs ("\"><data key=\"target_flags\">", m_file);
+	writeFlags (flags, ' ');
+	fputs ("</data></edge>\n", m_file);
+}
+
+void GraphMLExporter::writeString (const char* str)
+{
+	for (; *str; str++)
+	{
+		switch (*str)
+		{
+			case '&':  fputs ("&amp;",  m_file); break;
+			case '<':  fputs ("&lt;",   m_file); break;
+			case '>':  fputs ("&gt;",   m_file); break;
+			case '"':  fputs ("&quot;", m_file); break;
+			case '\'': fputs ("&apos;", m_file); break;
+			default:   fputc (*str,     m_file);
+		}
+	}
+}
+
+//--------------------------------
+
+CsvExporter::CsvExporter (const char* filename):
+	FileExporter (filename)
+{
+	if (m_file)
+		fputs ("source,target,target_flags\n", m_file);
+}
+
+// Edge lists have no standalone node records, the target flags
+// column carries what the node record would have said.
+
+void CsvExporter::node (const char* name, unsigned flags)
+{}
+
+void CsvExporter::edge (const char* from, const char* to, unsigned flags)
+{
+	writeString (from);
+	fputc (',', m_file);
+	writeString (to);
+	fputc (',', m_file);
+	writeFlags (flags, '|');
+	fputc ('\n', m_file);
+}
+
+void CsvExporter::writeString (const char* str)
+{
+	if (!strpbrk (str, ",\"\r\n"))
+	{
+		fputs (str, m_file);
+		return;
+	}
+
+	fputc ('"', m_file);
+	for (; *str; str++)
+	{
+		if (*str == '"') fputc ('"', m_file);
+		fputc (*str, m_file);
+	}
+	fputc ('"', m_file);
+}
+
+//--------------------------------
@@ -0,0 +1,141 @@
+#pragma once
+
+//--------------------------------
+
+#include <vector>
+#include <cstdio>
+
+#include "Graph.h"
+#include "DependencyGraph.h"
+
+//--------------------------------
+
+// Sink for modules and edges as the crawl discovers them.
+//
+// Every module is reported once, when its flags (DependencyGraph::Flags)
+// are known, and every edge as soon as it is found, with the flags of the
+// target module. Writers stream straight into a FILE and keep no per
+// record state, so memory use does not grow with the graph.
+
+class Exporter
+{
+public :
+	virtual ~Exporter ();
+
+	virtual void node (const char* name, unsigned flags) = 0;
+	virtual void edge (const char* from, const char* to, unsigned flags) = 0;
+
+	virtual bool ok () const;
+
+	void replay (const DependencyGraph& graph);
+
+	static Exporter* Create (const char* format, const char* filename);
+
+};
+
+//--------------------------------
+
+class TeeExporter: public Exporter
+{
+public :
+	void attach (Exporter* exporter);
+
+	virtual void node (const char* name, unsigned flags);
+	virtual void edge (const char* from, const char* to, unsigned flags);
+
+private :
+	std::vector <Exporter*> m_exporters;
+
+};
+
+//--------------------------------
+
+class DotExporter: public Exporter
+{
+public :
+	// Priorities of the attributes given to the graph: a missing module
+	// stays red whatever else is said about it
+	enum Priority
+	{
+		Plain,
+		Flagged,
+		Cycle,
+		SelfImport,
+		Broken
+	};
+
+	DotExporter (Graph* graph);
+
+	virtual void node (const char* name, unsigned flags);
+	virtual void edge (const char* from, const char* to, unsigned flags);
+
+private :
+	Graph* m_graph;
+
+};
+
+//--------------------------------
+
+class FileExporter: public Exporter
+{
+public :
+	FileExporter (const char* filename);
+	virtual ~FileExporter ();
+
+	virtual bool ok () const;
+
+protected :
+	FILE* m_file;
+
+	void writeFlags (unsigned flags, char separator);
+
+};
+
+//--------------------------------
+
+class JsonLinesExporter: public FileExporter
+{
+public :
+	JsonLinesExporter (const char* filename);
+
+	virtual void node (const char* name, unsigned flags);
+	virtual void edge (const char* from, const char* to, unsigned flags);
+
+private :
+	void writeString (const char* str);
+	void writeFlags  (unsigned flags);
+
+};
+
+//--------------------------------
+
+class GraphMLExporter: public FileExporter
+{
+public :
+	GraphMLExporter (const char* filename);
+	virtual ~GraphMLExporter ();
+
+	virtual void node (const char* name, unsigned flags);
+	virtual void edge (const char* from, const char* to, unsigned flags);
+
+private :
+	void writeString (const char* str);
+
+};
+
+//--------------------------------
+
+class CsvExporter: public FileExporter
+{
+public :
+	CsvExporter (const char* filename);
+
+	virtual void node (const char* name, unsigned flags);
+	virtual void edge (const char* from, const char* to, unsigned flags);
+
+private :
+	void writeString (const char* str);
+
+};
+
+//--------------------------------
@@ -2,6 +2,12 @@
 
 //--------------------------------
 
+#include <cstring>
+
+#include <Windows.h>
+#include <io.h>
+#include <fcntl.h>
+
 #include "Graph.h"
 
 //--------------------------------
@@ -11,27 +17,48 @@ const char* Graph::Color::Green       = "\"#257D22FF\"";
 const char* Graph::Color::LightGreen  = "\"#D0FFD0FF\"";
 const char* Graph::Color::Blue        = "\"#0080FFFF\"";
 const char* Graph::Color::LightBlue   = "\"#9ED7FFFF\"";
+const char* Graph::Color::Red         = "\"#A02020FF\"";
 const char* Graph::Color::DarkGrey    = "\"#181818FF\"";
 const char* Graph::Color::Transparent = "\"#00000000\"";
 
 //--------------------------------
 
 Graph::Graph (std::string name):
-	m_name (name),
-	m_file (nullptr),
-	m_tabs (0)
+	m_name       (name),
+	m_file       (nullptr),
+	m_pipe       (nullptr),
+	m_process    (nullptr),
+	m_renderer   (DOT_PATH),
+	m_tabs       (0),
+	m_started    (false),
+	m_names      (),
+	m_nodes      (),
+	m_slots      (),
+	m_edges      (),
+	m_edge_index (),
+	m_sets       (),
+	m_set_index  (),
+	m_merges     ()
 {
 	fopen_s (&m_file, filename.c_str (), "w");
 	assert (m_file);
 
-	add ("strict digraph G");
-	add ("{");
+	// Set 0 is no attributes at all
+	intern ({});
 }
 
 Graph::~Graph ()
 {
-	fclose (m_file);
-	m_file = nullptr;
+	if (m_file) fclose (m_file);
+	if (m_pipe) fclose (m_pipe);
+
+	// Renderer that was started but never waited for gets its input
+	// closed above and is left to finish on its own
+	if (m_process) CloseHandle (m_process);
+
+	m_file    = nullptr;
+	m_pipe    = nullptr;
+	m_process = nullptr;
 }
 
 //--------------------------------
@@ -49,6 +76,27 @@ void Graph::add (const char* format, ...)
 	vsprintf_s (str, buffsize, format, args);
 	va_end (args);
 
+	emit (str);
+	delete[] (str);
+}
+
+void Graph::emit (const char* str)
+{
+	// The header is written lazily so that stream () can still redirect
+	// everything, including the first line, into the renderer
+	if (!m_started)
+	{
+		m_started = true;
+
+		write ("strict digraph G");
+		write ("{");
+	}
+
+	write (str);
+}
+
+void Graph::write (const char* str)
+{
 	size_t indent = 4*m_tabs;
 	for (const char* l_str = str; *l_str; l_str++)
 	{
@@ -64,28 +112,388 @@ void Graph::add (const char* format, ...)
 	if (m_tabs < 0)
 		m_tabs = 0;
 
-	fprintf (m_file, "%*s%s\n", indent, "", str);
-	delete[] (str);
+	if (m_file) fprintf (m_file, "%*s%s\n", indent, "", str);
+	if (m_pipe) fprintf (m_pipe, "%*s%s\n", indent, "", str);
 }
 
 //--------------------------------
 
-int Graph::render ()
+void Graph::node (const char* name, Attributes attributes /*= {}*/, int priority /*= 0*/)
+{
+	bool created = false;
+	int  node    = find (name, &created);
+	int  set     = merge (m_nodes[node].set, attributes, priority);
+
+	// A value only given again with a higher priority changes nothing
+	// in the output
+	std::string text = m_pipe? changes (m_nodes[node].set, set): "";
+	if (!text.empty ())
+		statement ("\"" + std::string (name) + "\"", text);
+
+	m_nodes[node].set = set;
+}
+
+void Graph::edge (const char* from, const char* to, Attributes attributes /*= {}*/, int priority /*= 0*/)
+{
+	bool named     = false;
+	int  from_node = find (from, &named);
+	int  to_node   = find (to,   &named);
+
+	uint64_t key = (uint64_t) from_node << 32 | (uint32_t) to_node;
+
+	auto found   = m_edge_index.find (key);
+	bool created = found == m_edge_index.end ();
+
+	if (created)
+	{
+		found = m_edge_index.emplace (key, (int) m_edges.size ()).first;
+		m_edges.push_back ({(uint32_t) from_node, (uint32_t) to_node, 0});
+
+		m_nodes[from_node].linked = true;
+		m_nodes[to_node]  .linked = true;
+	}
+
+	Edge& edge = m_edges[found -> second];
+	int   set  = merge (edge.set, attributes, priority);
+
+	// Restating an edge of a strict graph updates the one already there
+	std::string text = m_pipe? changes (edge.set, set): "";
+	if ((created && m_pipe) || !text.empty ())
+		statement ("\"" + std::string (from) + "\" -> \"" + to + "\"", text);
+
+	edge.set = set;
+}
+
+int Graph::getNodesCount () const
+{
+	return (int) m_nodes.size ();
+}
+
+int Graph::getEdgesCount () const
+{
+	return (int) m_edges.size ();
+}
+
+//--------------------------------
+
+// Node ids go into the slots shifted by one, 0 is a free slot. The table
+// is kept at most half full.
+
+int Graph::find (const char* name, bool* created)
+{
+	uint32_t hash = 2166136261u;
+	for (const char* c = name; *c; c++)
+		hash = (hash ^ (unsigned char) *c) * 16777619u;
+
+	if (m_nodes.size () * 2 >= m_slots.size ())
+		grow ();
+
+	size_t mask = m_slots.size () - 1;
+	for (size_t slot = hash & mask;; slot = (slot + 1) & mask)
+	{
+		int node = m_slots[slot] - 1;
+		if (node == -1)
+		{
+			m_nodes.push_back ({(uint32_t) m_names.size (), hash, 0, false});
+			m_names.append (name, strlen (name) + 1);
+
+			m_slots[slot] = (int) m_nodes.size ();
+
+			*created = true;
+			return (int) m_nodes.size () - 1;
+		}
+
+		if (m_nodes[node].hash == hash && strcmp (m_names.c_str () + m_nodes[node].name, name) == 0)
+		{
+			*created = false;
+			return node;
+		}
+	}
+}
+
+void Graph::grow ()
 {
-	add ("}");
+	m_slots.assign (m_slots.empty ()? 64: m_slots.size () * 2, 0);
 
+	size_t mask = m_slots.size () - 1;
+	for (size_t node = 0; node < m_nodes.size (); node++)
+	{
+		size_t slot = m_nodes[node].hash & mask;
+		while (m_slots[slot])
+			slot = (slot + 1) & mask;
+
+		m_slots[slot] = (int) node + 1;
+	}
+}
+
+//--------------------------------
+
+int Graph::intern (std::vector <Setting> settings)
+{
+	std::string key;
+	for (const Setting& setting: settings)
+		key += setting.name + "=" + setting.value + "@" + std::to_string (setting.priority) + "\n";
+
+	auto found = m_set_index.find (key);
+	if (found != m_set_index.end ())
+		return found -> second;
+
+	Set set = {std::move (settings), ""};
+	for (const Setting& setting: set.settings)
+	{
+		if (!set.text.empty ()) set.text += ", ";
+		set.text += setting.name + " = " + setting.value;
+	}
+
+	m_set_index.emplace (std::move (key), (int) m_sets.size ());
+	m_sets.push_back (std::move (set));
+
+	return (int) m_sets.size () - 1;
+}
+
+// Merges the attributes into a set, one by one, the way the renderer
+// merges restated statements. The few pairs of sets that meet are only
+// worked out once.
+
+int Graph::merge (int set, Attributes attributes, int priority)
+{
+	if (attributes.size () == 0)
+		return set;
+
+	std::vector <Setting> given;
+	for (const Attribute& attribute: attributes)
+		given.push_back ({attribute.name, attribute.value, priority});
+
+	int given_set = intern (std::move (given));
+
+	uint64_t key   = (uint64_t) set << 32 | (uint32_t) given_set;
+	auto     found = m_merges.find (key);
+	if (found != m_merges.end ())
+		return found -> second;
+
+	std::vector <Setting> settings = m_sets[set].settings;
+	for (const Setting& attribute: m_sets[given_set].settings)
+	{
+		auto setting = settings.begin ();
+		while (setting != settings.end () && setting -> name != attribute.name)
+			setting++;
+
+		if (setting == settings.end ())
+			settings.push_back (attribute);
+
+		else if (attribute.priority >= setting -> priority)
+			*setting = attribute;
+	}
+
+	int merged = intern (std::move (settings));
+	m_merges.emplace (key, merged);
+
+	return merged;
+}
+
+// The attributes of a set that another one doesn't already give the
+// same value, as written between the brackets
+
+std::string Graph::changes (int from, int to)
+{
+	std::string text;
+	for (const Setting& setting: m_sets[to].settings)
+	{
+		bool same = false;
+		for (const Setting& old: m_sets[from].settings)
+			same |= old.name == setting.name && old.value == setting.value;
+
+		if (same) continue;
+
+		if (!text.empty ()) text += ", ";
+		text += setting.name + " = " + setting.value;
+	}
+
+	return text;
+}
+
+void Graph::statement (const std::string& target, const std::string& text)
+{
+	if (!text.empty ()) emit ((target + " [" + text + "];").c_str ());
+	else                emit ((target + ";").c_str ());
+}
+
+//--------------------------------
+
+// Writes what the graph still owes the output before it is closed. When
+// streaming that is only the nodes nothing has named yet, otherwise every
+// node with attributes or without edges, then every edge.
+
+void Graph::flush ()
+{
+	for (const Node& node: m_nodes)
+		if (m_pipe? !node.set && !node.linked: node.set || !node.linked)
+			statement ("\"" + std::string (m_names.c_str () + node.name) + "\"", m_sets[node.set].text);
+
+	if (m_pipe)
+		return;
+
+	for (const Edge& edge: m_edges)
+		statement ("\"" + std::string (m_names.c_str () + m_nodes[edge.from].name) + "\" -> \"" + (m_names.c_str () + m_nodes[edge.to].name) + "\"", m_sets[edge.set].text);
+}
+
+//--------------------------------
+
+int Graph::render ()
+{
 	assert (available ());
 
-	char cmd [BUFFSIZE] = "";
-	sprintf_s (cmd, "\"%s\" %s -Tpng -o%s", DOT_PATH, filename.c_str (), image.c_str ());
+	return renderAsync ().get ();
+}
 
-	fclose (m_file);
+//--------------------------------
 
-	int status = system (cmd);
-	if (status == 0)
-		fopen_s (&m_file, filename.c_str (), "a");
+// Starts the renderer right away and feeds it every line as it is added,
+// so layout overlaps with the crawl instead of waiting for the whole
+// file. Has to be called before the first add (). The .graph.txt copy
+// is only kept on disk when asked for.
+
+bool Graph::stream (bool keep_file /*= true*/)
+{
+	assert (!m_started && !m_pipe);
+
+	if (!spawn (true))
+		return false;
+
+	if (!keep_file)
+	{
+		fclose (m_file);
+		m_file = nullptr;
+
+		remove (filename.c_str ());
+	}
+
+	return true;
+}
+
+//--------------------------------
+
+// Closes the graph and returns a future for the renderer exit code. When
+// streaming, closing the pipe is what lets the renderer finish; otherwise
+// it is started on the written file. The optional callback is invoked
+// with the exit code on the waiting thread.
+
+std::future <int> Graph::renderAsync (std::function <void (int)> done /*= nullptr*/)
+{
+	flush ();
+	emit ("}");
+
+	if (m_file)
+	{
+		fclose (m_file);
+		m_file = nullptr;
+	}
+
+	if (m_pipe)
+	{
+		fclose (m_pipe);
+		m_pipe = nullptr;
+	}
 
-	return status;
+	else if (!m_process)
+		spawn (false);
+
+	HANDLE process = m_process;
+	m_process = nullptr;
+
+	return std::async (std::launch::async, [process, done] ()
+	{
+		DWORD status = (DWORD) -1;
+		if (process)
+		{
+			WaitForSingleObject (process, INFINITE);
+			GetExitCodeProcess  (process, &status);
+			CloseHandle         (process);
+		}
+
+		if (done)
+			done ((int) status);
+
+		return (int) status;
+	});
+}
+
+//--------------------------------
+
+// Runs the renderer directly, without going through the shell. With
+// from_pipe the graph is read from a pipe connected to its stdin and
+// m_pipe becomes the writing end, otherwise from the .graph.txt file.
+
+bool Graph::spawn (bool from_pipe)
+{
+	std::string cmd = "\"" + m_renderer + "\" -Tpng \"-o" + image + "\"";
+	if (!from_pipe)
+		cmd += " \"" + filename + "\"";
+
+	SECURITY_ATTRIBUTES attributes = {sizeof (attributes), nullptr, TRUE};
+	STARTUPINFOA        startup    = {sizeof (startup)};
+	PROCESS_INFORMATION info       = {};
+
+	HANDLE input  = nullptr;
+	HANDLE output = nullptr;
+
+	if (from_pipe)
+	{
+		if (!CreatePipe (&input, &output, &attributes, 0))
+			return false;
+
+		// Only the reading end is inherited, otherwise the renderer would
+		// hold its own input open and never see the end of the graph
+		SetHandleInformation (output, HANDLE_FLAG_INHERIT, 0);
+
+		startup.dwFlags    = STARTF_USESTDHANDLES;
+		startup.hStdInput  = input;
+		startup.hStdOutput = GetStdHandle (STD_OUTPUT_HANDLE);
+		startup.hStdError  = GetStdHandle (STD_ERROR_HANDLE);
+	}
+
+	BOOL created = CreateProcessA (m_renderer.c_str (), &cmd[0], nullptr, nullptr, from_pipe, 0, nullptr, nullptr, &startup, &info);
+
+	if (input)
+		CloseHandle (input);
+
+	if (!created)
+	{
+		if (output) CloseHandle (output);
+		return false;
+	}
+
+	CloseHandle (info.hThread);
+	m_process = info.hProcess;
+
+	if (from_pipe)
+	{
+		int fd = _open_osfhandle ((intptr_t) output, _O_WRONLY | _O_TEXT);
+		m_pipe = fd == -1? nullptr: _fdopen (fd, "w");
+
+		assert (m_pipe);
+	}
+
+	return true;
+}
+
+//--------------------------------
+
+// Bare names such as "dot" are looked up on PATH, the way the shell would
+
+void Graph::setRenderer (std::string path)
+{
+	assert (!m_process);
+
+	char  resolved[MAX_PATH] = "";
+	DWORD length             = SearchPathA (nullptr, path.c_str (), ".exe", MAX_PATH, resolved, nullptr);
+
+	m_renderer = length && length < MAX_PATH? resolved: path;
+}
+
+std::string Graph::getRenderer ()
+{
+	return m_renderer;
 }
 
 //--------------------------------
@@ -105,7 +513,7 @@ std::string Graph::getImage ()
 bool Graph::available ()
 {
 	FILE* file = nullptr;
-	errno_t err = fopen_s (&file, DOT_PATH, "r");
+	errno_t err = fopen_s (&file, m_renderer.c_str (), "r");
 	if (!file || err)
 	{
 		if (file) fclose (file);
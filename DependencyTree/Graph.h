@@ -3,8 +3,14 @@
 //--------------------------------
 
 #include <string>
+#include <vector>
 #include <cstdio>
+#include <cstdint>
 #include <cassert>
+#include <future>
+#include <functional>
+#include <unordered_map>
+#include <initializer_list>
 #include <stdarg.h>
 
 //--------------------------------
@@ -41,12 +47,42 @@
 class DECLSPEC Graph
 {
 public :
+	struct Attribute
+	{
+		const char* name;
+		const char* value; // Written as is, quotes included
+	};
+
+	typedef std::initializer_list <Attribute> Attributes;
+
 	 Graph (std::string name);
 	~Graph ();
 
 	void add       (const char* format, ...);
 	int  render    ();
 	bool available ();
+
+	// Nodes and edges are declared once however often they are given.
+	// Attributes are merged one by one, each keeps the value given with
+	// the highest priority, the latest among equals. Nodes without
+	// attributes are left to the edges that name them.
+	//
+	// The statements are written when the graph is closed, nodes then edges
+	// in first-seen order. When streaming they are written as soon as they
+	// are first given instead, and an attribute won later is sent as a short
+	// update that the renderer merges over the first statement; the output
+	// then follows the crawl order rather than this canonical one.
+	void node (const char* name, Attributes attributes = {}, int priority = 0);
+	void edge (const char* from, const char* to, Attributes attributes = {}, int priority = 0);
+
+	int getNodesCount () const;
+	int getEdgesCount () const;
+
+	bool              stream      (bool keep_file = true);
+	std::future <int> renderAsync (std::function <void (int)> done = nullptr);
+
+	void        setRenderer (std::string path);
+	std::string getRenderer ();
 	
 	std::string getFilename ();
 	__declspec (property (get = getFilename)) std::string filename;
@@ -61,14 +97,71 @@ public :
 		static const char* LightGreen;
 		static const char* Blue;
 		static const char* LightBlue;
+		static const char* Red;
 		static const char* DarkGrey;
 		static const char* Transparent;
 	};
 
 private :
+	struct Setting
+	{
+		std::string name;
+		std::string value;
+		int         priority;
+	};
+
+	// Attribute sets are few and shared by every node and edge using them,
+	// set 0 is no attributes at all
+	struct Set
+	{
+		std::vector <Setting> settings;
+		std::string           text; // As written between the brackets
+	};
+
+	struct Node
+	{
+		uint32_t name; // Into m_names
+		uint32_t hash;
+		int      set;
+		bool     linked;
+	};
+
+	struct Edge
+	{
+		uint32_t from;
+		uint32_t to;
+		int      set;
+	};
+
 	FILE*       m_file;
+	FILE*       m_pipe;
+	void*       m_process;
 	std::string m_name;
+	std::string m_renderer;
 	int         m_tabs;
+	bool        m_started;
+
+	// Node names are stored once, back to back, and found through an open
+	// addressed table of node ids; edges are keyed by their pair of ids.
+	std::string                           m_names;
+	std::vector        <Node>             m_nodes;
+	std::vector        <int>              m_slots;
+	std::vector        <Edge>             m_edges;
+	std::unordered_map <uint64_t, int>    m_edge_index;
+	std::vector        <Set>              m_sets;
+	std::unordered_map <std::string, int> m_set_index;
+	std::unordered_map <uint64_t, int>    m_merges;
+
+	void        emit      (const char* str);
+	void        write     (const char* str);
+	bool        spawn     (bool from_pipe);
+	int         find      (const char* name, bool* created);
+	void        grow      ();
+	int         intern    (std::vector <Setting> settings);
+	int         merge     (int set, Attributes attributes, int priority);
+	std::string changes   (int from, int to);
+	void        statement (const std::string& target, const std::string& text);
+	void        flush     ();
 
 };
 
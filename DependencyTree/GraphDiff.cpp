@@ -0,0 +1,253 @@
+#include <cctype>
+#include <iterator>
+#include <algorithm>
+
+#include "GraphDiff.h"
+
+//--------------------------------
+
+namespace
+{
+	struct SortedModule
+	{
+		std::string key;
+		int         module;
+	};
+
+	struct SortedEdge
+	{
+		std::string from;
+		std::string to;
+		int         from_module;
+		int         to_module;
+	};
+
+	std::string Canonical (const char* name)
+	{
+		std::string key (name);
+		for (char& c: key)
+			c = (char) tolower ((unsigned char) c);
+
+		return key;
+	}
+
+	std::vector <SortedModule> SortModules (const DependencyGraph& graph)
+	{
+		std::vector <SortedModule> modules;
+		modules.reserve (graph.getModulesCount ());
+
+		for (int module = 0, count = graph.getModulesCount (); module < count; module++)
+			modules.push_back ({Canonical (graph.getModuleName (module)), module});
+
+		std::sort (modules.begin (), modules.end (), [] (const SortedModule& a, const SortedModule& b) { return a.key < b.key; });
+		return modules;
+	}
+
+	std::vector <SortedEdge> SortEdges (const DependencyGraph& graph)
+	{
+		std::vector <std::string> keys;
+		keys.reserve (graph.getModulesCount ());
+
+		for (int module = 0, count = graph.getModulesCount (); module < count; module++)
+			keys.push_back (Canonical (graph.getModuleName (module)));
+
+		std::vector <SortedEdge> edges;
+		edges.reserve (graph.getEdgesCount ());
+
+		for (int from = 0, count = graph.getModulesCount (); from < count; from++)
+			for (int to: graph.getDependencies (from))
+				edges.push_back ({keys[from], keys[to], from, to});
+
+		std::sort (edges.begin (), edges.end (), [] (const SortedEdge& a, const SortedEdge& b) { return a.from != b.from? a.from < b.from: a.to < b.to; });
+		return edges;
+	}
+
+	int CompareEdges (const SortedEdge& a, const SortedEdge& b)
+	{
+		int order = a.from.compare (b.from);
+		return order? order: a.to.compare (b.to);
+	}
+
+	// Modules are drawn with the spelling of the later scan whenever it has
+	// them, so a module whose case changed stays a single node
+	const char* Spelling (const DependencyGraph& before, const DependencyGraph& after, int old_module)
+	{
+		const char* name   = before.getModuleName (old_module);
+		int         module = after.findModule (name);
+
+		return module != -1? after.getModuleName (module): name;
+	}
+}
+
+//--------------------------------
+
+GraphDiff::GraphDiff ():
+	m_modules (),
+	m_edges   ()
+{}
+
+//--------------------------------
+
+void GraphDiff::compare (const DependencyGraph& before, const DependencyGraph& after)
+{
+	m_modules.clear ();
+	m_edges  .clear ();
+
+	compareModules (before, after);
+	compareEdges   (before, after);
+}
+
+//--------------------------------
+
+void GraphDiff::compareModules (const DependencyGraph& before, const DependencyGraph& after)
+{
+	std::vector <SortedModule> old_modules = SortModules (before);
+	std::vector <SortedModule> new_modules = SortModules (after );
+
+	size_t i = 0, j = 0;
+	while (i < old_modules.size () || j < new_modules.size ())
+	{
+		int order = i == old_modules.size ()? 1:
+		            j == new_modules.size ()? -1:
+		            old_modules[i].key.compare (new_modules[j].key);
+
+		if (order < 0)
+		{
+			m_modules.push_back ({before.getModuleName (old_modules[i++].module), Removed, {}, {}});
+			continue;
+		}
+
+		if (order > 0)
+		{
+			m_modules.push_back ({after.getModuleName (new_modules[j++].module), Added, {}, {}});
+			continue;
+		}
+
+		int old_module = old_modules[i++].module;
+		int new_module = new_modules[j++].module;
+
+		if (before.getImportsHash (old_module) == after.getImportsHash (new_module))
+			continue;
+
+		const std::vector <std::string>& old_imports = before.getImports (old_module);
+		const std::vector <std::string>& new_imports = after .getImports (new_module);
+
+		ModuleChange change = {after.getModuleName (new_module), Changed, {}, {}};
+		std::set_difference (new_imports.begin (), new_imports.end (), old_imports.begin (), old_imports.end (), std::back_inserter (change.added_imports  ));
+		std::set_difference (old_imports.begin (), old_imports.end (), new_imports.begin (), new_imports.end (), std::back_inserter (change.removed_imports));
+
+		m_modules.push_back (std::move (change));
+	}
+}
+
+//--------------------------------
+
+void GraphDiff::compareEdges (const DependencyGraph& before, const DependencyGraph& after)
+{
+	std::vector <SortedEdge> old_edges = SortEdges (before);
+	std::vector <SortedEdge> new_edges = SortEdges (after );
+
+	size_t i = 0, j = 0;
+	while (i < old_edges.size () || j < new_edges.size ())
+	{
+		int order = i == old_edges.size ()? 1:
+		            j == new_edges.size ()? -1:
+		            CompareEdges (old_edges[i], new_edges[j]);
+
+		if (order < 0)
+		{
+			const SortedEdge& edge = old_edges[i++];
+			m_edges.push_back ({Spelling (before, after, edge.from_module), Spelling (before, after, edge.to_module), Removed});
+		}
+
+		else
+		{
+			const SortedEdge& edge = new_edges[j++];
+			m_edges.push_back ({after.getModuleName (edge.from_module), after.getModuleName (edge.to_module), order > 0? Added: Same});
+
+			if (order == 0) i++;
+		}
+	}
+}
+
+//--------------------------------
+
+bool GraphDiff::empty () const
+{
+	if (!m_modules.empty ())
+		return false;
+
+	for (const EdgeChange& edge: m_edges)
+		if (edge.change != Same) return false;
+
+	return true;
+}
+
+//--------------------------------
+
+const std::vector <GraphDiff::ModuleChange>& GraphDiff::getModules () const
+{
+	return m_modules;
+}
+
+const std::vector <GraphDiff::EdgeChange>& GraphDiff::getEdges () const
+{
+	return m_edges;
+}
+
+//--------------------------------
+
+void GraphDiff::report (FILE* file) const
+{
+	static const char Signs[] = {' ', '+', '-', '~'};
+
+	for (const ModuleChange& module: m_modules)
+	{
+		fprintf (file, "%c module %s\n", Signs[module.change], module.name.c_str ());
+
+		for (const std::string& symbol: module.added_imports)
+			fprintf (file, "    + import %s\n", symbol.c_str ());
+
+		for (const std::string& symbol: module.removed_imports)
+			fprintf (file, "    - import %s\n", symbol.c_str ());
+	}
+
+	size_t added = 0, removed = 0;
+	for (const EdgeChange& edge: m_edges)
+	{
+		if (edge.change == Same) continue;
+
+		fprintf (file, "%c edge %s -> %s\n", Signs[edge.change], edge.from.c_str (), edge.to.c_str ());
+		(edge.change == Added? added: removed)++;
+	}
+
+	fprintf (file, "%zu module(s) changed, %zu edge(s) added, %zu edge(s) removed\n", m_modules.size (), added, removed);
+}
+
+//--------------------------------
+
+void GraphDiff::draw (Graph* graph) const
+{
+	for (const ModuleChange& module: m_modules)
+	{
+		const char* color = module.change == Added?   Graph::Color::Green:
+		                    module.change == Removed? Graph::Color::Red:
+		                                              Graph::Color::Blue;
+
+		graph -> node (module.name.c_str (), {{"style", "filled"}, {"fillcolor", color}});
+	}
+
+	for (const EdgeChange& edge: m_edges)
+	{
+		if (edge.change == Same)
+			graph -> edge (edge.from.c_str (), edge.to.c_str ());
+
+		else
+		{
+			const char* color = edge.change == Added? Graph::Color::Green: Graph::Color::Red;
+			graph -> edge (edge.from.c_str (), edge.to.c_str (), {{"color", color}, {"fillcolor", color}});
+		}
+	}
+}
+
+//--------------------------------
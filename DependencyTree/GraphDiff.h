@@ -0,0 +1,66 @@
+#pragma once
+
+//--------------------------------
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "Graph.h"
+#include "DependencyGraph.h"
+
+//--------------------------------
+
+// Difference between two scan snapshots.
+//
+// Both scans are reduced to canonically sorted module and edge lists and
+// merged in a single linear pass. Modules present in both scans are only
+// compared symbol by symbol when their import hashes differ.
+
+class GraphDiff
+{
+public :
+	enum Change
+	{
+		Same,
+		Added,
+		Removed,
+		Changed
+	};
+
+	struct ModuleChange
+	{
+		std::string               name;
+		Change                    change;
+		std::vector <std::string> added_imports;
+		std::vector <std::string> removed_imports;
+	};
+
+	struct EdgeChange
+	{
+		std::string from;
+		std::string to;
+		Change      change;
+	};
+
+	GraphDiff ();
+
+	void compare (const DependencyGraph& before, const DependencyGraph& after);
+	bool empty   () const;
+
+	const std::vector <ModuleChange>& getModules () const;
+	const std::vector <EdgeChange>&   getEdges   () const;
+
+	void report (FILE* file) const;
+	void draw   (Graph* graph) const;
+
+private :
+	std::vector <ModuleChange> m_modules;
+	std::vector <EdgeChange>   m_edges;
+
+	void compareModules (const DependencyGraph& before, const DependencyGraph& after);
+	void compareEdges   (const DependencyGraph& before, const DependencyGraph& after);
+
+};
+
+//--------------------------------
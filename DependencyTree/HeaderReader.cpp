@@ -0,0 +1,648 @@
+#include <set>
+#include <iterator>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include <Windows.h>
+#include "BasicModuleInfo.h"
+#include "HeaderReader.h"
+
+//--------------------------------
+
+static const size_t   MaxStringSize = 4096;
+static const uint32_t MaxSections   = 96;
+static const uint32_t MaxEntries    = 1 << 20;
+
+// Directories are asked for as a whole up to this size, their names and
+// tables usually sit right next to them
+static const uint32_t MaxPrefetch = 256 * 1024;
+
+//--------------------------------
+
+namespace
+{
+	// The pages of a file read so far. Reads that need pages which aren't
+	// there fail and leave those pages behind as missing, for the next round
+
+	class SparseFile
+	{
+	public :
+		SparseFile (uint64_t size):
+			m_size    (size),
+			m_pages   (),
+			m_missing ()
+		{}
+
+		bool read   (uint64_t offset, void* data, size_t size);
+		bool string (uint64_t offset, std::string* string);
+		void want   (uint64_t offset, size_t size);
+		void insert (uint64_t page, const char* data, size_t size);
+
+		uint64_t             getSize    () const { return m_size;    }
+		std::set <uint64_t>* getMissing ()       { return &m_missing; }
+
+	private :
+		uint64_t                                           m_size;
+		std::unordered_map <uint64_t, std::vector <char>> m_pages;
+		std::set <uint64_t>                                m_missing;
+
+	};
+
+	bool SparseFile::read (uint64_t offset, void* data, size_t size)
+	{
+		if (offset > m_size || m_size - offset < size)
+			return false;
+
+		if (!size)
+			return true;
+
+		bool complete = true;
+		for (uint64_t page = offset / HeaderReader::PageSize, last = (offset + size - 1) / HeaderReader::PageSize; page <= last; page++)
+		{
+			if (m_pages.count (page)) continue;
+
+			m_missing.insert (page);
+			complete = false;
+		}
+
+		if (!complete)
+			return false;
+
+		char* out = (char*) data;
+		while (size)
+		{
+			const std::vector <char>& page = m_pages[offset / HeaderReader::PageSize];
+
+			size_t start = offset % HeaderReader::PageSize;
+			size_t chunk = HeaderReader::PageSize - start < size? HeaderReader::PageSize - start: size;
+
+			memcpy (out, page.data () + start, chunk);
+
+			out    += chunk;
+			offset += chunk;
+			size   -= chunk;
+		}
+
+		return true;
+	}
+
+	bool SparseFile::string (uint64_t offset, std::string* string)
+	{
+		string -> clear ();
+
+		while (offset < m_size && string -> size () < MaxStringSize)
+		{
+			uint64_t page  = offset / HeaderReader::PageSize;
+			auto     found = m_pages.find (page);
+			if (found == m_pages.end ())
+			{
+				m_missing.insert (page);
+				return false;
+			}
+
+			const char* begin = found -> second.data () + offset % HeaderReader::PageSize;
+			const char* end   = found -> second.data () + found -> second.size ();
+			const char* zero  = (const char*) memchr (begin, 0, end - begin);
+
+			string -> append (begin, zero? zero: end);
+			if (zero)
+				return true;
+
+			offset += end - begin;
+		}
+
+		return false;
+	}
+
+	void SparseFile::want (uint64_t offset, size_t size)
+	{
+		if (offset >= m_size || !size)
+			return;
+
+		if (size > m_size - offset)
+			size = (size_t) (m_size - offset);
+
+		for (uint64_t page = offset / HeaderReader::PageSize, last = (offset + size - 1) / HeaderReader::PageSize; page <= last; page++)
+			if (!m_pages.count (page)) m_missing.insert (page);
+	}
+
+	void SparseFile::insert (uint64_t page, const char* data, size_t size)
+	{
+		m_pages[page].assign (data, data + size);
+		m_missing.erase (page);
+	}
+
+	//--------------------------------
+
+	struct Layout
+	{
+		uint32_t                             headers_size;
+		IMAGE_DATA_DIRECTORY                 exports;
+		IMAGE_DATA_DIRECTORY                 imports;
+		IMAGE_DATA_DIRECTORY                 iat;
+		std::vector <IMAGE_SECTION_HEADER>   sections;
+	};
+
+	// Where the data at rva is in the file. Parts of a section past its raw
+	// data are zero filled by the loader, there is nothing to read there
+
+	bool Offset (const Layout& layout, uint32_t rva, uint64_t* offset)
+	{
+		if (rva < layout.headers_size)
+		{
+			*offset = rva;
+			return true;
+		}
+
+		for (const IMAGE_SECTION_HEADER& section: layout.sections)
+		{
+			if (rva < section.VirtualAddress || rva - section.VirtualAddress >= section.SizeOfRawData) continue;
+
+			*offset = (uint64_t) (section.PointerToRawData & ~0x1FFu) + (rva - section.VirtualAddress);
+			return true;
+		}
+
+		return false;
+	}
+
+	bool Read (SparseFile* file, const Layout& layout, uint32_t rva, void* data, size_t size)
+	{
+		uint64_t offset = 0;
+		return Offset (layout, rva, &offset) && file -> read (offset, data, size);
+	}
+
+	bool String (SparseFile* file, const Layout& layout, uint32_t rva, std::string* string)
+	{
+		uint64_t offset = 0;
+		return Offset (layout, rva, &offset) && file -> string (offset, string);
+	}
+
+	void Want (SparseFile* file, const Layout& layout, const IMAGE_DATA_DIRECTORY& directory)
+	{
+		uint64_t offset = 0;
+		if (directory.VirtualAddress && Offset (layout, directory.VirtualAddress, &offset))
+			file -> want (offset, directory.Size < MaxPrefetch? directory.Size: MaxPrefetch);
+	}
+
+	//--------------------------------
+
+	template <typename optional_t>
+	bool ReadLayout (SparseFile* file, uint64_t offset, const IMAGE_FILE_HEADER& header, Layout* layout)
+	{
+		optional_t optional = {};
+		if (!file -> read (offset, &optional, header.SizeOfOptionalHeader < sizeof (optional)? header.SizeOfOptionalHeader: sizeof (optional)))
+			return false;
+
+		// A shorter optional header has fewer data directories, the rest
+		// were zeroed above
+		uint32_t directories = optional.NumberOfRvaAndSizes;
+		layout -> headers_size = optional.SizeOfHeaders;
+		layout -> exports      = directories > IMAGE_DIRECTORY_ENTRY_EXPORT? optional.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT]: IMAGE_DATA_DIRECTORY ();
+		layout -> imports      = directories > IMAGE_DIRECTORY_ENTRY_IMPORT? optional.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT]: IMAGE_DATA_DIRECTORY ();
+		layout -> iat          = directories > IMAGE_DIRECTORY_ENTRY_IAT?    optional.DataDirectory[IMAGE_DIRECTORY_ENTRY_IAT   ]: IMAGE_DATA_DIRECTORY ();
+
+		if (header.NumberOfSections > MaxSections)
+			return false;
+
+		layout -> sections.resize (header.NumberOfSections);
+		return file -> read (offset + header.SizeOfOptionalHeader, layout -> sections.data (), layout -> sections.size () * sizeof (IMAGE_SECTION_HEADER));
+	}
+
+	// Same summary as ImageCache builds from a mapped image. A read that
+	// fails doesn't stop the parse, so that every page missing at this
+	// stage is asked for in the same round
+
+	bool ReadExports (SparseFile* file, const Layout& layout, ModuleSummary* summary)
+	{
+		IMAGE_EXPORT_DIRECTORY directory = {};
+		if (!Read (file, layout, layout.exports.VirtualAddress, &directory, sizeof (directory)))
+			return false;
+
+		if (directory.NumberOfNames > MaxEntries)
+			return false;
+
+		bool complete = true;
+		for (uint32_t i = 0; i < directory.NumberOfNames; i++)
+		{
+			DWORD name_rva = 0;
+			WORD  index    = 0;
+			std::string name;
+
+			if (!Read   (file, layout, directory.AddressOfNames        + i * sizeof (DWORD), &name_rva, sizeof (name_rva)) ||
+			    !Read   (file, layout, directory.AddressOfNameOrdinals + i * sizeof (WORD ), &index,    sizeof (index   )) ||
+			    !String (file, layout, name_rva, &name))
+			{
+				complete = false;
+				continue;
+			}
+
+			if (index >= directory.NumberOfFunctions)
+			{
+				summary -> exports.push_back ({name, -1, ""});
+				continue;
+			}
+
+			// An address inside the export directory is the name of the
+			// function it forwards to
+			DWORD       address = 0;
+			std::string forwarder;
+
+			if (!Read (file, layout, directory.AddressOfFunctions + index * sizeof (DWORD), &address, sizeof (address)))
+			{
+				complete = false;
+				continue;
+			}
+
+			if (address >= layout.exports.VirtualAddress && address - layout.exports.VirtualAddress < layout.exports.Size &&
+			    !String (file, layout, address, &forwarder))
+			{
+				complete = false;
+				continue;
+			}
+
+			summary -> exports.push_back ({name, (int) (directory.Base + index), forwarder});
+		}
+
+		return complete;
+	}
+
+	template <typename thunk_t>
+	bool ReadImports (SparseFile* file, const Layout& layout, ModuleSummary* summary, thunk_t ordinal_flag)
+	{
+		bool complete = true;
+		for (uint32_t i = 0; i < MaxEntries; i++)
+		{
+			IMAGE_IMPORT_DESCRIPTOR descriptor = {};
+			if (!Read (file, layout, layout.imports.VirtualAddress + i * sizeof (descriptor), &descriptor, sizeof (descriptor)))
+				return false;
+
+			if (!descriptor.Name)
+				return complete;
+
+			std::string module;
+			if (!String (file, layout, descriptor.Name, &module))
+			{
+				complete = false;
+				continue;
+			}
+
+			summary -> dependencies.push_back (module);
+
+			std::string prefix (module);
+			for (char& c: prefix)
+				c = (char) tolower ((unsigned char) c);
+
+			prefix += '!';
+
+			// Without an import name table the names are lost once the
+			// image is bound, ModuleInfo doesn't list them either
+			if (!descriptor.OriginalFirstThunk) continue;
+
+			for (uint32_t j = 0; j < MaxEntries; j++)
+			{
+				thunk_t thunk = 0;
+				if (!Read (file, layout, descriptor.OriginalFirstThunk + j * sizeof (thunk), &thunk, sizeof (thunk)))
+				{
+					complete = false;
+					break;
+				}
+
+				if (!thunk) break;
+
+				if (thunk & ordinal_flag)
+				{
+					summary -> imports.push_back (prefix + "#" + std::to_string ((int) IMAGE_ORDINAL (thunk)));
+					continue;
+				}
+
+				// Skipping the hint
+				std::string name;
+				if (String (file, layout, (uint32_t) thunk + sizeof (WORD), &name))
+					summary -> imports.push_back (prefix + name);
+
+				else complete = false;
+			}
+		}
+
+		return false;
+	}
+
+	bool ParsePe (SparseFile* file, ModuleSummary* summary)
+	{
+		IMAGE_DOS_HEADER dos = {};
+		if (!file -> read (0, &dos, sizeof (dos)) || dos.e_magic != IMAGE_DOS_SIGNATURE)
+			return false;
+
+		uint64_t          nt        = (uint32_t) dos.e_lfanew;
+		DWORD             signature = 0;
+		IMAGE_FILE_HEADER header    = {};
+		WORD              magic     = 0;
+
+		if (!file -> read (nt,                          &signature, sizeof (signature)) ||
+		    !file -> read (nt + sizeof (signature),     &header,    sizeof (header   )) ||
+		    !file -> read (nt + sizeof (signature) + sizeof (header), &magic, sizeof (magic)))
+			return false;
+
+		if (signature != IMAGE_NT_SIGNATURE)
+			return false;
+
+		uint64_t optional = nt + sizeof (signature) + sizeof (header);
+		bool     pe64     = magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+
+		Layout layout = {};
+		if      (pe64)                                   { if (!ReadLayout <IMAGE_OPTIONAL_HEADER64> (file, optional, header, &layout)) return false; }
+		else if (magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC) { if (!ReadLayout <IMAGE_OPTIONAL_HEADER32> (file, optional, header, &layout)) return false; }
+		else return false;
+
+		Want (file, layout, layout.exports);
+		Want (file, layout, layout.imports);
+		Want (file, layout, layout.iat);
+
+		bool complete = true;
+
+		if (layout.exports.VirtualAddress && !ReadExports (file, layout, summary))
+			complete = false;
+
+		if (layout.imports.VirtualAddress)
+		{
+			bool imports = pe64? ReadImports <ULONGLONG> (file, layout, summary, IMAGE_ORDINAL_FLAG64):
+			                     ReadImports <DWORD    > (file, layout, summary, IMAGE_ORDINAL_FLAG32);
+			if (!imports)
+				complete = false;
+		}
+
+		std::sort (summary -> imports.begin (), summary -> imports.end ());
+		summary -> imports.erase (std::unique (summary -> imports.begin (), summary -> imports.end ()), summary -> imports.end ());
+
+		return complete;
+	}
+}
+
+//--------------------------------
+
+struct HeaderReader::File
+{
+	int        index;
+	HANDLE     handle;
+	SparseFile pages;
+	int        pending;
+	bool       failed;
+};
+
+// The OVERLAPPED comes first, completions hand back a pointer to it
+struct HeaderReader::Read
+{
+	OVERLAPPED         overlapped;
+	File*              file;
+	uint64_t           page;
+	std::vector <char> buffer;
+};
+
+//--------------------------------
+
+HeaderReader::HeaderReader ():
+	m_paths         (),
+	m_max_in_flight (DefaultMaxInFlight),
+	m_port          (nullptr),
+	m_async         (false),
+	m_reads         (0),
+	m_rounds        (0),
+	m_bytes         (0)
+{}
+
+//--------------------------------
+
+void HeaderReader::setMaxInFlight (int files)
+{
+	m_max_in_flight = files;
+}
+
+void HeaderReader::add (const char* path)
+{
+	m_paths.push_back (path);
+}
+
+//--------------------------------
+
+int HeaderReader::getReadsCount () const
+{
+	return m_reads;
+}
+
+int HeaderReader::getRoundsCount () const
+{
+	return m_rounds;
+}
+
+uint64_t HeaderReader::getBytesRead () const
+{
+	return m_bytes;
+}
+
+bool HeaderReader::isAsync () const
+{
+	return m_async;
+}
+
+//--------------------------------
+
+void HeaderReader::run (Callback callback)
+{
+	if (m_max_in_flight > 0)
+	{
+		m_port = CreateIoCompletionPort (INVALID_HANDLE_VALUE, nullptr, 0, 0);
+		if (!m_port)
+			printf ("Warning: Failed to create an I/O completion port, files will be read one at a time: %s\n", FormatWinapiError (GetLastError ()));
+	}
+
+	m_async = m_port != nullptr;
+
+	int next      = 0;
+	int in_flight = 0;
+
+	while (next < (int) m_paths.size () || in_flight)
+	{
+		// Without a port every file is read to the end before the next one
+		while (next < (int) m_paths.size () && in_flight < (m_port? m_max_in_flight: 1))
+		{
+			int   index = next++;
+			File* file  = open (index);
+
+			if (!file)
+				callback (index, m_paths[index].c_str (), nullptr);
+
+			else if (advance (file, callback))
+				in_flight++;
+		}
+
+		if (!in_flight) continue;
+
+		DWORD       bytes      = 0;
+		ULONG_PTR   key        = 0;
+		OVERLAPPED* overlapped = nullptr;
+
+		BOOL ok = GetQueuedCompletionStatus (m_port, &bytes, &key, &overlapped, INFINITE);
+		if (!overlapped)
+		{
+			// Reads still in flight own their buffers, they are left alone
+			printf ("Warning: Waiting for reads failed: %s\n", FormatWinapiError (GetLastError ()));
+			return;
+		}
+
+		Read* read = (Read*) overlapped;
+		File* file = read -> file;
+
+		if (!ok || bytes != read -> buffer.size ())
+			file -> failed = true;
+
+		else for (size_t offset = 0, page = read -> page; offset < bytes; offset += PageSize, page++)
+			file -> pages.insert (page, read -> buffer.data () + offset, bytes - offset < PageSize? bytes - offset: PageSize);
+
+		delete read;
+
+		if (--file -> pending) continue;
+
+		in_flight--;
+		if (advance (file, callback))
+			in_flight++;
+	}
+
+	if (m_port)
+		CloseHandle (m_port);
+
+	m_port = nullptr;
+}
+
+//--------------------------------
+
+HeaderReader::File* HeaderReader::open (int index)
+{
+	const char* path  = m_paths[index].c_str ();
+	DWORD       flags = FILE_FLAG_RANDOM_ACCESS | (m_port? FILE_FLAG_OVERLAPPED: 0);
+
+	HANDLE handle = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx (handle, &size) || (m_port && !CreateIoCompletionPort (handle, m_port, 0, 0)))
+	{
+		CloseHandle (handle);
+		return nullptr;
+	}
+
+	return new File {index, handle, SparseFile ((uint64_t) size.QuadPart), 0, false};
+}
+
+//--------------------------------
+
+// Runs the parser over the pages read so far and asks for the ones it
+// is missing. Returns true while the file has reads in flight; without a
+// port the reads are done right away and the parser is run again.
+
+bool HeaderReader::advance (File* file, const Callback& callback)
+{
+	while (!file -> failed)
+	{
+		std::shared_ptr <ModuleSummary> summary = std::make_shared <ModuleSummary> ();
+
+		bool parsed = ParsePe (&file -> pages, summary.get ());
+		if (file -> pages.getMissing () -> empty ())
+		{
+			finish (file, parsed? summary: nullptr, callback);
+			return false;
+		}
+
+		m_rounds++;
+
+		if (!issue (file))
+			break;
+
+		if (m_port)
+			return true;
+	}
+
+	finish (file, nullptr, callback);
+	return false;
+}
+
+//--------------------------------
+
+// Reads the missing pages, adjacent ones together. With a port the
+// completions are picked up by run, otherwise the pages are in when this
+// returns.
+
+bool HeaderReader::issue (File* file)
+{
+	std::set <uint64_t>* missing = file -> pages.getMissing ();
+	uint64_t             size    = file -> pages.getSize ();
+
+	while (!missing -> empty () && !file -> failed)
+	{
+		uint64_t first = *missing -> begin ();
+		uint64_t count = 1;
+
+		for (auto page = std::next (missing -> begin ()); page != missing -> end () && *page == first + count && count < MaxReadPages; page++)
+			count++;
+
+		for (uint64_t i = 0; i < count; i++)
+			missing -> erase (first + i);
+
+		uint64_t offset = first * PageSize;
+		uint64_t length = size - offset < count * PageSize? size - offset: count * PageSize;
+
+		Read* read = new Read {};
+		read -> file = file;
+		read -> page = first;
+		read -> buffer.resize ((size_t) length);
+		read -> overlapped.Offset     = (DWORD) offset;
+		read -> overlapped.OffsetHigh = (DWORD) (offset >> 32);
+
+		m_reads++;
+		m_bytes += length;
+
+		DWORD done = 0;
+		BOOL  ok   = ReadFile (file -> handle, read -> buffer.data (), (DWORD) length, m_port? nullptr: &done, &read -> overlapped);
+
+		if (m_port)
+		{
+			if (ok || GetLastError () == ERROR_IO_PENDING)
+			{
+				file -> pending++;
+				continue;
+			}
+
+			file -> failed = true;
+		}
+
+		// A handle opened without FILE_FLAG_OVERLAPPED reads at the offset
+		// and returns once the data is in
+		else if (ok && done == length)
+		{
+			for (size_t at = 0, page = first; at < done; at += PageSize, page++)
+				file -> pages.insert (page, read -> buffer.data () + at, done - at < PageSize? done - at: PageSize);
+		}
+
+		else file -> failed = true;
+
+		delete read;
+	}
+
+	missing -> clear ();
+	return file -> pending > 0 || (!m_port && !file -> failed);
+}
+
+//--------------------------------
+
+void HeaderReader::finish (File* file, std::shared_ptr <const ModuleSummary> summary, const Callback& callback)
+{
+	CloseHandle (file -> handle);
+	callback (file -> index, m_paths[file -> index].c_str (), summary);
+
+	delete file;
+}
+
+//--------------------------------
@@ -0,0 +1,78 @@
+#pragma once
+
+//--------------------------------
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "ImageCache.h"
+
+//--------------------------------
+
+// Batched reader of the PE structures a scan needs: the headers, the
+// section table and the import and export directories, usually a few
+// pages of a much larger file.
+//
+// Each file is parsed from a sparse cache of its pages. The parser is
+// restarted every round; the pages it couldn't find are read in one
+// batch, fewest reads possible, and it runs again once they are all in.
+// A dozen reads per file over a handful of rounds is typical.
+//
+// Many files are kept in flight at once with overlapped reads on an I/O
+// completion port, so a cold corpus on a network share or a spinning disk
+// is read at the speed of the storage rather than one seek at a time.
+// Without a completion port, or with setMaxInFlight (0), files are read
+// one after another with plain positioned reads.
+//
+// Both PE32 and PE32+ files are read. Files that are not PE, or that the
+// reader can't make sense of, are reported with a nullptr summary and can
+// be handed to ImageCache instead.
+
+class HeaderReader
+{
+public :
+	// Called once per file, in completion order, index is the order the
+	// file was added in
+	typedef std::function <void (int index, const char* path, std::shared_ptr <const ModuleSummary> summary)> Callback;
+
+	HeaderReader ();
+
+	void setMaxInFlight (int files);
+
+	void add (const char* path);
+	void run (Callback callback);
+
+	int      getReadsCount  () const;
+	int      getRoundsCount () const;
+	uint64_t getBytesRead   () const;
+	bool     isAsync        () const;
+
+	static const int    DefaultMaxInFlight = 64;
+	static const size_t PageSize           = 4096;
+
+	// Adjacent missing pages are read together, up to this many at once
+	static const size_t MaxReadPages = 16;
+
+private :
+	struct File;
+	struct Read;
+
+	std::vector <std::string> m_paths;
+	int                       m_max_in_flight;
+	void*                     m_port;
+	bool                      m_async;
+	int                       m_reads;
+	int                       m_rounds;
+	uint64_t                  m_bytes;
+
+	File* open    (int index);
+	bool  advance (File* file, const Callback& callback);
+	bool  issue   (File* file);
+	void  finish  (File* file, std::shared_ptr <const ModuleSummary> summary, const Callback& callback);
+
+};
+
+//--------------------------------
@@ -0,0 +1,437 @@
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#include <Windows.h>
+#include "BasicModuleInfo.h"
+#include "ModuleInfo.h"
+#include "ElfModuleInfo.h"
+#include "ImageCache.h"
+
+//--------------------------------
+
+static const uint64_t FnvOffset = 0xCBF29CE484222325ull;
+static const uint64_t FnvPrime  = 0x00000100000001B3ull;
+
+static const size_t HeaderSize = 4096;
+static const size_t ChunkSize  = 256 * 1024;
+
+//--------------------------------
+
+namespace
+{
+	uint64_t HashBytes (const void* data, size_t size, uint64_t hash = FnvOffset)
+	{
+		const unsigned char* bytes = (const unsigned char*) data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FnvPrime;
+		}
+
+		return hash;
+	}
+
+	std::string Lowercase (const char* text)
+	{
+		std::string result (text);
+		for (char& c: result)
+			c = (char) tolower ((unsigned char) c);
+
+		return result;
+	}
+
+	// Exports that only have an ordinal are left out, they can't be
+	// looked up by name
+
+	void SummarizeExports (ModuleInfo* info, ModuleSummary* summary)
+	{
+		if (!info -> getNTEntry () -> OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress)
+			return;
+
+		int count = info -> getExportFunctionsNamesCount ();
+		summary -> exports.reserve (count);
+
+		for (int i = 0; i < count; i++)
+		{
+			int         index     = info -> getExportNameFunctionIndex (i);
+			const char* forwarder = info -> getExportFunctionForwarder (index);
+
+			summary -> exports.push_back ({info -> getExportFunctionName (i), info -> getExportFunctionOrdinal (index), forwarder? forwarder: ""});
+		}
+	}
+
+	void Summarize (ModuleInfo* info, ModuleSummary* summary)
+	{
+		SummarizeExports (info, summary);
+
+		// Without an import directory the import entry points at the image
+		// base, there is nothing to walk
+		if (!info -> getNTEntry () -> OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress)
+			return;
+
+		for (int i = 0, modules_count = info -> getImportModulesCount (); i < modules_count; i++)
+		{
+			summary -> dependencies.push_back (info -> getImportModuleName (i));
+
+			std::string prefix = Lowercase (info -> getImportModuleName (i)) + '!';
+
+			for (int j = 0, functions_count = info -> getImportFunctionsCount (i); j < functions_count; j++)
+			{
+				int ordinal = info -> getImportFunctionOrdinal (i, j);
+				if (ordinal != -1)
+					summary -> imports.push_back (prefix + "#" + std::to_string (ordinal));
+
+				else if (const char* name = info -> getImportFunctionName (i, j))
+					summary -> imports.push_back (prefix + name);
+
+				else info -> clearError ();
+			}
+		}
+	}
+
+	void SummarizeElf (ElfModuleInfo* info, ModuleSummary* summary)
+	{
+		for (int i = 0, modules_count = info -> getImportModulesCount (); i < modules_count; i++)
+		{
+			if (const char* name = info -> getImportModuleName (i))
+				summary -> dependencies.push_back (name);
+
+			else info -> clearError ();
+		}
+
+		for (int i = 0, symbols_count = info -> getSymbolsCount (); i < symbols_count; i++)
+		{
+			const char* name = info -> getSymbolName (i);
+			if (!name)
+			{
+				info -> clearError ();
+				continue;
+			}
+
+			if      (info -> isSymbolImported (i)) summary -> imports.push_back (name);
+			else if (info -> isSymbolExported (i)) summary -> exports.push_back ({name, 0, ""});
+		}
+
+		if (const char* run_path = info -> getRunPath ())
+		{
+			for (const char* begin = run_path; *begin; )
+			{
+				const char* end = strchr (begin, ':');
+				if (!end)
+					end = begin + strlen (begin);
+
+				if (end != begin)
+					summary -> search_paths.emplace_back (begin, end);
+
+				begin = *end? end + 1: end;
+			}
+		}
+	}
+
+	// Summaries outlive the mappings they came from for the whole scan,
+	// they shouldn't hold on to more memory than they use. Imports are
+	// sorted here once, the scan shares them as they are.
+
+	void Compact (ModuleSummary* summary)
+	{
+		std::vector <std::string>& imports = summary -> imports;
+		std::sort (imports.begin (), imports.end ());
+		imports.erase (std::unique (imports.begin (), imports.end ()), imports.end ());
+
+		summary -> dependencies.shrink_to_fit ();
+		summary -> imports.shrink_to_fit ();
+		summary -> exports.shrink_to_fit ();
+		summary -> search_paths.shrink_to_fit ();
+	}
+
+	// Expands $ORIGIN, the directory of the module being loaded, the one
+	// dynamic string token that matters for finding files
+
+	std::string ExpandOrigin (const std::string& search_path, const std::string& origin)
+	{
+		std::string result;
+
+		for (size_t i = 0; i < search_path.size (); )
+		{
+			if      (search_path.compare (i, 7, "$ORIGIN")   == 0) { result += origin; i += 7; }
+			else if (search_path.compare (i, 9, "${ORIGIN}") == 0) { result += origin; i += 9; }
+			else result += search_path[i++];
+		}
+
+		return result;
+	}
+
+	bool IsFile (const char* path)
+	{
+		DWORD attributes = GetFileAttributesA (path);
+		return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+	}
+}
+
+//--------------------------------
+
+ImageCache::ImageCache ():
+	m_files        (),
+	m_images       (),
+	m_locations    (),
+	m_mappings     (),
+	m_images_count (0)
+{}
+
+//--------------------------------
+
+// Records where the dependencies of the module at path are, as its ELF
+// search path sees them. The first module to locate a name wins, like a
+// loader that already has the library mapped.
+
+void ImageCache::locateDependencies (const char* path, const ModuleSummary& summary)
+{
+	if (summary.search_paths.empty ())
+		return;
+
+	std::string origin (path);
+	size_t      separator = origin.find_last_of ("/\\");
+	origin.resize (separator == std::string::npos? 0: separator);
+
+	for (const std::string& dependency: summary.dependencies)
+	{
+		std::string key = Lowercase (dependency.c_str ());
+		if (m_locations.count (key)) continue;
+
+		for (const std::string& search_path: summary.search_paths)
+		{
+			std::string candidate = ExpandOrigin (search_path, origin) + '/' + dependency;
+			if (!IsFile (candidate.c_str ())) continue;
+
+			m_locations[key] = candidate;
+			break;
+		}
+	}
+}
+
+bool ImageCache::locate (const char* name, char* path, size_t max) const
+{
+	auto location = m_locations.find (Lowercase (name));
+	if (location == m_locations.end () || location -> second.size () >= max)
+		return Resolve (name, path, max);
+
+	strcpy_s (path, max, location -> second.c_str ());
+	return true;
+}
+
+//--------------------------------
+
+MappingManager* ImageCache::getMappings ()
+{
+	return &m_mappings;
+}
+
+int ImageCache::getFilesCount () const
+{
+	return (int) m_files.size ();
+}
+
+int ImageCache::getImagesCount () const
+{
+	return m_images_count;
+}
+
+//--------------------------------
+
+// Returns the summary of the image at path, parsing it only if no
+// identical image was parsed before. nullptr if it can't be read.
+
+std::shared_ptr <const ModuleSummary> ImageCache::get (const char* path)
+{
+	std::string key = Lowercase (path);
+
+	auto file = m_files.find (key);
+	if (file != m_files.end ())
+		return file -> second;
+
+	uint64_t size        = 0;
+	uint64_t header_hash = 0;
+	bool     elf         = false;
+	if (!Fingerprint (path, &size, &header_hash, &elf))
+		return nullptr;
+
+	std::vector <Image>& candidates = m_images[header_hash ^ (size * FnvPrime)];
+
+	uint64_t content_hash = 0;
+	bool     hashed       = false;
+
+	for (Image& image: candidates)
+	{
+		if (image.size != size || image.header_hash != header_hash) continue;
+
+		if (!hashed && !hashContent (path, &content_hash))
+			return nullptr;
+
+		hashed = true;
+
+		if (!image.hashed && !hashContent (image.path.c_str (), &image.content_hash)) continue;
+		image.hashed = true;
+
+		if (image.content_hash == content_hash)
+		{
+			m_files[key] = image.summary;
+			return image.summary;
+		}
+	}
+
+	std::shared_ptr <const ModuleSummary> summary = parse (path, elf);
+	if (!summary)
+		return nullptr;
+
+	candidates.push_back ({path, size, header_hash, content_hash, hashed, summary});
+	m_images_count++;
+
+	m_files[key] = summary;
+	return summary;
+}
+
+//--------------------------------
+
+// Most files are told apart by their first page alone, mapping the whole
+// file for it would count all of it against the mapping budget
+
+bool ImageCache::Fingerprint (const char* path, uint64_t* size, uint64_t* header_hash, bool* elf)
+{
+	HANDLE file = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		printf ("Warning: Failed to open '%s': %s\n", path, FormatWinapiError (GetLastError ()));
+		return false;
+	}
+
+	LARGE_INTEGER file_size  = {};
+	OVERLAPPED    overlapped = {};
+	char          header[HeaderSize];
+	DWORD         read = 0;
+
+	// A positioned read past the end fails, it is kept within the file
+	bool  ok     = GetFileSizeEx (file, &file_size) != FALSE;
+	DWORD length = (uint64_t) file_size.QuadPart < HeaderSize? (DWORD) file_size.QuadPart: (DWORD) HeaderSize;
+
+	ok = ok && (!length || ReadFile (file, header, length, &read, &overlapped));
+	CloseHandle (file);
+
+	if (!ok)
+	{
+		printf ("Warning: Failed to read '%s': %s\n", path, FormatWinapiError (GetLastError ()));
+		return false;
+	}
+
+	*size        = (uint64_t) file_size.QuadPart;
+	*header_hash = HashBytes (header, read);
+	*elf         = ElfModuleInfo::IsElf (header, read);
+
+	return true;
+}
+
+bool ImageCache::hashContent (const char* path, uint64_t* hash)
+{
+	std::shared_ptr <const MappingManager::View> view = m_mappings.map (path, MappingManager::Data);
+	if (!view)
+		return false;
+
+	*hash = FnvOffset;
+
+	// Read ahead of the hash a chunk at a time, the whole file may not fit
+	// in the working set
+	for (size_t offset = 0; offset < view -> size; offset += ChunkSize)
+	{
+		MappingManager::Prefetch (*view, offset + ChunkSize, ChunkSize);
+
+		size_t size = view -> size - offset < ChunkSize? view -> size - offset: ChunkSize;
+		*hash = HashBytes (view -> data + offset, size, *hash);
+	}
+
+	return true;
+}
+
+//--------------------------------
+
+// Each file is mapped once, the way its format needs, as told by the
+// magic bytes of the fingerprint
+
+std::shared_ptr <const ModuleSummary> ImageCache::parse (const char* path, bool elf)
+{
+	std::shared_ptr <ModuleSummary> summary;
+
+	// ELF files are not images the loader knows, they are parsed as a
+	// plain view of the file
+	if (elf)
+	{
+		std::shared_ptr <const MappingManager::View> data = m_mappings.map (path, MappingManager::Data);
+		if (!data)
+			return nullptr;
+
+		ElfModuleInfo info;
+		if (!info.load (data -> data, data -> size))
+			printf ("Warning: '%s': %s\n", path, info.getError ());
+
+		else
+		{
+			summary = std::make_shared <ModuleSummary> ();
+			SummarizeElf (&info, summary.get ());
+			Compact (summary.get ());
+		}
+
+		return summary;
+	}
+
+	std::shared_ptr <const MappingManager::View> image = m_mappings.map (path, MappingManager::Image);
+	if (!image)
+		return nullptr;
+
+	ModuleInfo info;
+	if (!info.load ((HMODULE) image -> data))
+		printf ("%s\n", info.getError ());
+
+	else if (info.getNTEntry () -> OptionalHeader.Magic != IMAGE_NT_OPTIONAL_HDR_MAGIC)
+		printf ("Warning: '%s' is built for another architecture\n", path);
+
+	else
+	{
+		summary = std::make_shared <ModuleSummary> ();
+		Summarize (&info, summary.get ());
+		Compact (summary.get ());
+	}
+
+	return summary;
+}
+
+//--------------------------------
+
+// Finds the file a module name refers to. A name that is a path to an
+// existing file is taken as it is. Names that are not files on the search
+// path, such as API set contracts, are left for the loader to resolve,
+// without running any code of the module.
+
+bool ImageCache::Resolve (const char* name, char* path, size_t max)
+{
+	if (IsFile (name))
+	{
+		DWORD length = GetFullPathNameA (name, (DWORD) max, path, nullptr);
+		if (length && length < max)
+			return true;
+	}
+
+	DWORD length = SearchPathA (nullptr, name, ".dll", (DWORD) max, path, nullptr);
+	if (length && length < max)
+		return true;
+
+	HMODULE handle = LoadLibraryExA (name, nullptr, DONT_RESOLVE_DLL_REFERENCES);
+	if (!handle)
+		return false;
+
+	length = GetModuleFileNameA (handle, path, (DWORD) max);
+	FreeLibrary (handle);
+
+	return length && length < max;
+}
+
+//--------------------------------
@@ -0,0 +1,102 @@
+#pragma once
+
+//--------------------------------
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+#include "MappingManager.h"
+
+//--------------------------------
+
+// What the scan keeps from a parsed image, once its mapping is gone:
+// the modules it imports, in import table order, its imported symbols
+// as "module!function" (or "module!#ordinal"), lowercased, sorted and
+// without duplicates, and its named exports.
+//
+// ELF files have no ordinals and don't bind imports to a module, their
+// imports are plain symbol names, exports have ordinal 0, and the
+// directories of RUNPATH (or RPATH) go to search_paths.
+
+struct ModuleExport
+{
+	std::string name;
+	int         ordinal;
+	std::string forwarder;
+};
+
+struct ModuleSummary
+{
+	std::vector <std::string>  dependencies;
+	std::vector <std::string>  imports;
+	std::vector <ModuleExport> exports;
+	std::vector <std::string>  search_paths;
+};
+
+//--------------------------------
+
+// Content-addressed cache of parsed images.
+//
+// Byte-identical copies of a DLL under different paths (WinSxS, private
+// redistributables) are parsed once and share one summary. Files are
+// told apart by size and a hash of their first page, which holds the PE
+// headers; only when that fingerprint matches an image already parsed is
+// the whole content hashed to confirm it.
+//
+// PE images are mapped with SEC_IMAGE and parsed in place, no code of the
+// module is run. ELF files are mapped as plain data. All mappings go
+// through a MappingManager, which bounds how many of them are open; the
+// summaries are kept for the whole scan. The fingerprint is a plain read
+// of the first page, it doesn't take a mapping, and tells which of the
+// two mappings the file needs.
+//
+// Where dependencies live is learned from the modules that need them:
+// locateDependencies records the files an ELF search path points at, and
+// locate prefers those over the Windows search order.
+
+class ImageCache
+{
+public :
+	ImageCache ();
+
+	std::shared_ptr <const ModuleSummary> get (const char* path);
+
+	void locateDependencies (const char* path, const ModuleSummary& summary);
+	bool locate             (const char* name, char* path, size_t max) const;
+
+	MappingManager* getMappings ();
+
+	int getFilesCount  () const;
+	int getImagesCount () const;
+
+	static bool Resolve (const char* name, char* path, size_t max);
+
+private :
+	struct Image
+	{
+		std::string                           path;
+		uint64_t                              size;
+		uint64_t                              header_hash;
+		uint64_t                              content_hash;
+		bool                                  hashed;
+		std::shared_ptr <const ModuleSummary> summary;
+	};
+
+	std::unordered_map <std::string, std::shared_ptr <const ModuleSummary>> m_files;
+	std::unordered_map <uint64_t,    std::vector <Image>>                   m_images;
+	std::unordered_map <std::string, std::string>                           m_locations;
+	MappingManager                                                          m_mappings;
+	int                                                                     m_images_count;
+
+	bool hashContent (const char* path, uint64_t* hash);
+
+	std::shared_ptr <const ModuleSummary> parse (const char* path, bool elf);
+
+	static bool Fingerprint (const char* path, uint64_t* size, uint64_t* header_hash, bool* elf);
+
+};
+
+//--------------------------------
@@ -0,0 +1,303 @@
+#include <cctype>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+#include "ImportAnalytics.h"
+
+//--------------------------------
+
+// More shards than workers, so that a shard with popular names doesn't
+// keep the other workers waiting for long
+static const size_t ShardsPerThread = 4;
+
+//--------------------------------
+
+struct ImportAnalytics::Shard
+{
+	struct Entry
+	{
+		int count;
+		int user;
+		int last; // Last module counted, to count each one once
+	};
+
+	std::unordered_map <std::string, Entry> functions;
+	std::unordered_map <std::string, Entry> modules;
+};
+
+struct ImportAnalytics::Worker
+{
+	std::vector <Shard> shards;
+	std::vector <Count> fan_out;
+};
+
+//--------------------------------
+
+namespace
+{
+	void Merge (std::unordered_map <std::string, ImportAnalytics::Count>* merged, const std::string& name, int count, int user)
+	{
+		ImportAnalytics::Count& entry = (*merged)[name];
+		if (!entry.count || user < entry.user)
+			entry.user = user;
+
+		entry.count += count;
+	}
+}
+
+//--------------------------------
+
+ImportAnalytics::ImportAnalytics ():
+	m_modules   (),
+	m_summaries (),
+	m_threads   (0),
+	m_functions (),
+	m_fan_in    (),
+	m_fan_out   ()
+{}
+
+//--------------------------------
+
+// 0 uses a thread per core
+
+void ImportAnalytics::setThreadsCount (int threads)
+{
+	m_threads = threads;
+}
+
+void ImportAnalytics::add (const char* module, std::shared_ptr <const ModuleSummary> summary)
+{
+	m_modules.push_back (module);
+	m_summaries.push_back (summary);
+}
+
+//--------------------------------
+
+void ImportAnalytics::run ()
+{
+	size_t threads = m_threads > 0? m_threads: std::thread::hardware_concurrency ();
+	threads = std::max <size_t> (1, std::min (threads, m_summaries.size ()));
+
+	size_t shards = threads * ShardsPerThread;
+
+	std::vector <Worker> workers (threads);
+	for (Worker& worker: workers)
+		worker.shards.resize (shards);
+
+	std::vector <std::thread> pool;
+
+	for (size_t i = 0; i < threads; i++)
+		pool.emplace_back (&ImportAnalytics::count, this, &workers[i], m_summaries.size () * i / threads, m_summaries.size () * (i + 1) / threads);
+
+	for (std::thread& thread: pool)
+		thread.join ();
+
+	pool.clear ();
+
+	// Every shard is merged by a single worker, from the maps of all
+	std::vector <std::vector <Count>> functions (shards);
+	std::vector <std::vector <Count>> fan_in    (shards);
+
+	for (size_t i = 0; i < threads; i++)
+	{
+		pool.emplace_back ([this, &workers, &functions, &fan_in, i, threads, shards] ()
+		{
+			for (size_t shard = i; shard < shards; shard += threads)
+				reduce (&workers, shard, &functions[shard], &fan_in[shard]);
+		});
+	}
+
+	for (std::thread& thread: pool)
+		thread.join ();
+
+	m_functions.clear ();
+	m_fan_in.clear ();
+	m_fan_out.clear ();
+
+	for (size_t shard = 0; shard < shards; shard++)
+	{
+		m_functions.insert (m_functions.end (), functions[shard].begin (), functions[shard].end ());
+		m_fan_in.insert    (m_fan_in.end (),    fan_in[shard].begin (),    fan_in[shard].end ());
+	}
+
+	for (Worker& worker: workers)
+		m_fan_out.insert (m_fan_out.end (), worker.fan_out.begin (), worker.fan_out.end ());
+
+	Sort (&m_functions);
+	Sort (&m_fan_in);
+	Sort (&m_fan_out);
+}
+
+//--------------------------------
+
+// Counts modules [begin, end) into the worker's own shards. A module counts
+// once for each name, however many times it imports it. The summaries
+// keep their imports sorted and without duplicates, only the module names
+// have to be folded and told apart here.
+
+void ImportAnalytics::count (Worker* worker, size_t begin, size_t end) const
+{
+	std::hash <std::string> hash;
+	size_t                  shards = worker -> shards.size ();
+
+	std::string key;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		if (!m_summaries[i]) continue;
+
+		for (const std::string& name: m_summaries[i] -> imports)
+		{
+			Shard::Entry& entry = worker -> shards[hash (name) % shards].functions[name];
+			if (!entry.count++)
+				entry.user = (int) i;
+		}
+
+		int modules = 0;
+		for (const std::string& dependency: m_summaries[i] -> dependencies)
+		{
+			key.assign (dependency);
+			for (char& c: key)
+				c = (char) tolower ((unsigned char) c);
+
+			Shard::Entry& entry = worker -> shards[hash (key) % shards].modules[key];
+			if (entry.count && entry.last == (int) i) continue;
+
+			if (!entry.count++)
+				entry.user = (int) i;
+
+			entry.last = (int) i;
+			modules++;
+		}
+
+		worker -> fan_out.push_back ({m_modules[i], modules, (int) i});
+	}
+}
+
+void ImportAnalytics::reduce (std::vector <Worker>* workers, size_t shard, std::vector <Count>* functions, std::vector <Count>* fan_in) const
+{
+	std::unordered_map <std::string, Count> merged_functions;
+	std::unordered_map <std::string, Count> merged_modules;
+
+	for (Worker& worker: *workers)
+	{
+		for (const auto& entry: worker.shards[shard].functions)
+			Merge (&merged_functions, entry.first, entry.second.count, entry.second.user);
+
+		for (const auto& entry: worker.shards[shard].modules)
+			Merge (&merged_modules, entry.first, entry.second.count, entry.second.user);
+
+		// Nothing reads this shard of the worker again
+		worker.shards[shard] = Shard ();
+	}
+
+	for (auto& entry: merged_functions)
+		functions -> push_back ({entry.first, entry.second.count, entry.second.user});
+
+	for (auto& entry: merged_modules)
+		fan_in -> push_back ({entry.first, entry.second.count, entry.second.user});
+}
+
+//--------------------------------
+
+int ImportAnalytics::getModulesCount () const
+{
+	return (int) m_modules.size ();
+}
+
+const char* ImportAnalytics::getModuleName (int module) const
+{
+	return m_modules[module].c_str ();
+}
+
+const std::vector <ImportAnalytics::Count>& ImportAnalytics::getFunctions () const
+{
+	return m_functions;
+}
+
+const std::vector <ImportAnalytics::Count>& ImportAnalytics::getFanIn () const
+{
+	return m_fan_in;
+}
+
+const std::vector <ImportAnalytics::Count>& ImportAnalytics::getFanOut () const
+{
+	return m_fan_out;
+}
+
+//--------------------------------
+
+std::vector <ImportAnalytics::Count> ImportAnalytics::getSingleUserFunctions () const
+{
+	std::vector <Count> single;
+	for (const Count& function: m_functions)
+		if (function.count == 1) single.push_back (function);
+
+	return single;
+}
+
+std::vector <int> ImportAnalytics::Histogram (const std::vector <Count>& counts)
+{
+	std::vector <int> histogram;
+	for (const Count& entry: counts)
+	{
+		size_t bucket = 0;
+		while (bucket < 31 && entry.count >> (bucket + 1))
+			bucket++;
+
+		if (histogram.size () <= bucket)
+			histogram.resize (bucket + 1);
+
+		histogram[bucket]++;
+	}
+
+	return histogram;
+}
+
+//--------------------------------
+
+void ImportAnalytics::Sort (std::vector <Count>* counts)
+{
+	std::sort (counts -> begin (), counts -> end (), [] (const Count& a, const Count& b)
+	{
+		return a.count != b.count? a.count > b.count: a.name < b.name;
+	});
+}
+
+//--------------------------------
+
+void ImportAnalytics::report (FILE* file, int top) const
+{
+	fprintf (file, "%zu module(s) import %zu function(s) from %zu module(s)\n", m_modules.size (), m_functions.size (), m_fan_in.size ());
+
+	Report (file, "Most imported functions",             m_functions, top);
+	Report (file, "Most imported modules (fan-in)",      m_fan_in,    top);
+	Report (file, "Modules importing most (fan-out)",    m_fan_out,   top);
+
+	std::vector <Count> single = getSingleUserFunctions ();
+	fprintf (file, "\n%zu function(s) imported by a single module:\n", single.size ());
+
+	for (size_t i = 0; i < single.size () && (int) i < top; i++)
+		fprintf (file, "    %s (%s)\n", single[i].name.c_str (), m_modules[single[i].user].c_str ());
+
+	if (single.size () > (size_t) top)
+		fprintf (file, "    ...\n");
+
+	std::vector <int> histogram = Histogram (m_functions);
+	fprintf (file, "\nFunctions by number of importing modules:\n");
+
+	for (size_t i = 0; i < histogram.size (); i++)
+		fprintf (file, "    %8u - %-8u %d\n", 1u << i, (2u << i) - 1, histogram[i]);
+}
+
+void ImportAnalytics::Report (FILE* file, const char* title, const std::vector <Count>& counts, int top)
+{
+	fprintf (file, "\n%s:\n", title);
+
+	for (size_t i = 0; i < counts.size () && (int) i < top; i++)
+		fprintf (file, "    %8d  %s\n", counts[i].count, counts[i].name.c_str ());
+}
+
+//--------------------------------
@@ -0,0 +1,74 @@
+#pragma once
+
+//--------------------------------
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "ImageCache.h"
+
+//--------------------------------
+
+// Import statistics over a corpus of modules: how many modules import each
+// function and each module, how many modules each one imports, and the
+// functions only a single module uses.
+//
+// Counting is spread over worker threads. Each worker counts a slice of
+// the corpus into maps of its own, split into shards by hash; shard by
+// shard, the workers' maps are then merged by one worker each. No map is
+// shared between threads, there is no lock to wait on.
+
+class ImportAnalytics
+{
+public :
+	struct Count
+	{
+		std::string name;
+		int         count;
+		int         user;  // First module (in the order added) counted, for single users
+	};
+
+	ImportAnalytics ();
+
+	void setThreadsCount (int threads);
+
+	void add (const char* module, std::shared_ptr <const ModuleSummary> summary);
+	void run ();
+
+	int         getModulesCount () const;
+	const char* getModuleName   (int module) const;
+
+	// By count, highest first, then by name
+	const std::vector <Count>& getFunctions () const;
+	const std::vector <Count>& getFanIn     () const;
+	const std::vector <Count>& getFanOut    () const;
+
+	std::vector <Count> getSingleUserFunctions () const;
+
+	// Entry i counts the names with a count in [2^i, 2^(i+1))
+	static std::vector <int> Histogram (const std::vector <Count>& counts);
+
+	void report (FILE* file, int top) const;
+
+private :
+	struct Shard;
+	struct Worker;
+
+	std::vector <std::string>                           m_modules;
+	std::vector <std::shared_ptr <const ModuleSummary>> m_summaries;
+	int                                                 m_threads;
+	std::vector <Count>                                 m_functions;
+	std::vector <Count>                                 m_fan_in;
+	std::vector <Count>                                 m_fan_out;
+
+	void count  (Worker* worker, size_t begin, size_t end) const;
+	void reduce (std::vector <Worker>* workers, size_t shard, std::vector <Count>* functions, std::vector <Count>* fan_in) const;
+
+	static void Sort   (std::vector <Count>* counts);
+	static void Report (FILE* file, const char* title, const std::vector <Count>& counts, int top);
+
+};
+
+//--------------------------------
@@ -0,0 +1,200 @@
+#include <cctype>
+#include <cstdio>
+
+#include <Windows.h>
+#include "BasicModuleInfo.h"
+#include "MappingManager.h"
+
+//--------------------------------
+
+namespace
+{
+	// Sums the regions of a SEC_IMAGE view, which is laid out by sections
+	// and can be larger than the file
+
+	size_t ImageViewSize (const void* base)
+	{
+		size_t                   size    = 0;
+		const char*              address = (const char*) base;
+		MEMORY_BASIC_INFORMATION region  = {};
+
+		while (VirtualQuery (address, &region, sizeof (region)) && region.AllocationBase == base)
+		{
+			size    += region.RegionSize;
+			address += region.RegionSize;
+		}
+
+		return size;
+	}
+}
+
+//--------------------------------
+
+MappingManager::MappingManager (int max_mappings, uint64_t max_bytes):
+	m_entries      (),
+	m_index        (),
+	m_max_mappings (max_mappings),
+	m_max_bytes    (max_bytes),
+	m_bytes        (0),
+	m_peak_bytes   (0),
+	m_evictions    (0)
+{}
+
+//--------------------------------
+
+void MappingManager::setBudget (int max_mappings, uint64_t max_bytes)
+{
+	m_max_mappings = max_mappings;
+	m_max_bytes    = max_bytes;
+
+	evict ();
+}
+
+//--------------------------------
+
+int MappingManager::getMappingsCount () const
+{
+	return (int) m_entries.size ();
+}
+
+uint64_t MappingManager::getMappedBytes () const
+{
+	return m_bytes;
+}
+
+uint64_t MappingManager::getPeakBytes () const
+{
+	return m_peak_bytes;
+}
+
+int MappingManager::getEvictionsCount () const
+{
+	return m_evictions;
+}
+
+//--------------------------------
+
+// Returns a view of the file at path, mapping it only if it isn't mapped
+// already. nullptr if it can't be mapped.
+
+std::shared_ptr <const MappingManager::View> MappingManager::map (const char* path, Kind kind)
+{
+	std::string key (path);
+	for (char& c: key)
+		c = (char) tolower ((unsigned char) c);
+
+	key += kind == Image? "|image": "|data";
+
+	auto found = m_index.find (key);
+	if (found != m_index.end ())
+	{
+		m_entries.splice (m_entries.begin (), m_entries, found -> second);
+		return found -> second -> view;
+	}
+
+	std::shared_ptr <const View> view = Map (path, kind);
+	if (!view)
+		return nullptr;
+
+	m_entries.push_front ({key, view});
+	m_index[key] = m_entries.begin ();
+
+	m_bytes += view -> size;
+	if (m_bytes > m_peak_bytes)
+		m_peak_bytes = m_bytes;
+
+	evict ();
+	return view;
+}
+
+void MappingManager::clear ()
+{
+	m_entries.clear ();
+	m_index.clear ();
+
+	m_bytes = 0;
+}
+
+//--------------------------------
+
+// The most recently used view is kept even when it alone is over the
+// budget, the caller is about to read it
+
+void MappingManager::evict ()
+{
+	while (m_entries.size () > 1 && ((int) m_entries.size () > m_max_mappings || m_bytes > m_max_bytes))
+	{
+		Entry& entry = m_entries.back ();
+
+		m_bytes -= entry.view -> size;
+		m_index.erase (entry.key);
+		m_entries.pop_back ();
+
+		m_evictions++;
+	}
+}
+
+//--------------------------------
+
+// Asks for a range of the view to be read in ahead of use, in one large
+// read rather than a page fault at a time
+
+void MappingManager::Prefetch (const View& view, size_t offset, size_t size)
+{
+	if (offset >= view.size)
+		return;
+
+	if (size > view.size - offset)
+		size = view.size - offset;
+
+	WIN32_MEMORY_RANGE_ENTRY range = {(PVOID) (view.data + offset), size};
+	PrefetchVirtualMemory (GetCurrentProcess (), 1, &range, 0);
+}
+
+//--------------------------------
+
+std::shared_ptr <const MappingManager::View> MappingManager::Map (const char* path, Kind kind)
+{
+	HANDLE file = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		printf ("Warning: Failed to open '%s': %s\n", path, FormatWinapiError (GetLastError ()));
+		return nullptr;
+	}
+
+	LARGE_INTEGER file_size = {};
+	if (!GetFileSizeEx (file, &file_size) || !file_size.QuadPart)
+	{
+		printf ("Warning: '%s' is empty or can't be read\n", path);
+		CloseHandle (file);
+		return nullptr;
+	}
+
+	// The mapping and the view keep the file referenced on their own
+	HANDLE mapping = CreateFileMappingA (file, nullptr, kind == Image? PAGE_READONLY | SEC_IMAGE: PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle (file);
+
+	void* base = mapping? MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0): nullptr;
+	if (mapping)
+		CloseHandle (mapping);
+
+	if (!base)
+	{
+		printf ("Warning: Failed to map %s '%s': %s\n", kind == Image? "image": "file", path, FormatWinapiError (GetLastError ()));
+		return nullptr;
+	}
+
+	View* view = new View;
+	view -> data = (const char*) base;
+	view -> size = kind == Image? ImageViewSize (base): (size_t) file_size.QuadPart;
+
+	Prefetch (*view, 0, HeaderSize);
+
+	return std::shared_ptr <const View> (view, [] (const View* view)
+	{
+		UnmapViewOfFile (view -> data);
+		delete view;
+	});
+}
+
+//--------------------------------
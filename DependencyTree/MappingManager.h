@@ -0,0 +1,81 @@
+#pragma once
+
+//--------------------------------
+
+#include <list>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+//--------------------------------
+
+// Owns the file mappings of a scan.
+//
+// Views are kept open while they are likely to be read again (the content
+// hash of an image and its parse, for example) and the least recently used
+// ones are unmapped once the scan holds more than a set number of mappings
+// or bytes. The byte budget counts the size of the views, the most of them
+// that can be resident at once.
+//
+// A view handed out stays mapped for as long as the caller holds it, even
+// after it was evicted; the budget only limits what the manager keeps.
+
+class MappingManager
+{
+public :
+	enum Kind
+	{
+		Data,  // The file as it is on disk
+		Image  // Mapped with SEC_IMAGE, laid out by sections like the loader does
+	};
+
+	struct View
+	{
+		const char* data;
+		size_t      size;
+	};
+
+	MappingManager (int max_mappings = DefaultMaxMappings, uint64_t max_bytes = DefaultMaxBytes);
+
+	void setBudget (int max_mappings, uint64_t max_bytes);
+
+	std::shared_ptr <const View> map   (const char* path, Kind kind);
+	void                         clear ();
+
+	int      getMappingsCount  () const;
+	uint64_t getMappedBytes    () const;
+	uint64_t getPeakBytes      () const;
+	int      getEvictionsCount () const;
+
+	static void Prefetch (const View& view, size_t offset, size_t size);
+
+	static const int      DefaultMaxMappings = 256;
+	static const uint64_t DefaultMaxBytes    = 512ull * 1024 * 1024;
+
+	// Headers read first by the parsers
+	static const size_t HeaderSize = 64 * 1024;
+
+private :
+	struct Entry
+	{
+		std::string                  key;
+		std::shared_ptr <const View> view;
+	};
+
+	// Most recently used first
+	std::list          <Entry>                                    m_entries;
+	std::unordered_map <std::string, std::list <Entry>::iterator> m_index;
+	int                                                           m_max_mappings;
+	uint64_t                                                      m_max_bytes;
+	uint64_t                                                      m_bytes;
+	uint64_t                                                      m_peak_bytes;
+	int                                                           m_evictions;
+
+	void evict ();
+
+	static std::shared_ptr <const View> Map (const char* path, Kind kind);
+
+};
+
+//--------------------------------
@@ -2,6 +2,13 @@
 
 //---------------------
 
+#include <vector>
+#include <cstdint>
+
+#include "ProcName.h"
+
+//---------------------
+
 class ModuleInfo: public BasicModuleInfo
 {
 public:
@@ -24,16 +31,23 @@ public:
 	int                               getExportFunctionsNamesCount ();
 	const char*                       getExportFunctionName        (int         index);
 	int                               getExportFunctionIndex       (const char* name );
+	int                               getExportNameFunctionIndex   (int         name_index);
+	int                               getExportFunctionOrdinal     (int         index);
+	const char*                       getExportFunctionForwarder   (int         index);
 	template <typename proc_t> proc_t getExportFunctionAddress     (int         index);
 	template <typename proc_t> proc_t getExportFunctionAddress     (const char* name );
 	template <typename proc_t> bool   setExportFunctionAddress     (int         index, proc_t new_proc);
 	template <typename proc_t> bool   setExportFunctionAddress     (const char* name,  proc_t new_proc);
+	template <typename proc_t> int    getExportFunctionIndex       (const ProcName <proc_t>& name);
+	template <typename proc_t> proc_t getExportFunctionAddress     (const ProcName <proc_t>& name);
+	template <typename proc_t> bool   setExportFunctionAddress     (const ProcName <proc_t>& name, proc_t new_proc);
 
 	int                               getImportModulesCount        ();
 	const char*                       getImportModuleName          (int         index);
 	int                               getImportModuleIndex         (const char* name );
 	int                               getImportFunctionsCount      (int module_index );
 	const char*                       getImportFunctionName        (int module_index, int function_index);
+	int                               getImportFunctionOrdinal     (int module_index, int function_index);
 	int                               getImportFunctionIndex       (int module_index, const char* name          );
 	template <typename proc_t> proc_t getImportFunctionAddress     (int module_index, int         function_index);
 	template <typename proc_t> proc_t getImportFunctionAddress     (int module_index, const char* name          );
@@ -41,6 +55,8 @@ public:
 	template <typename proc_t> bool   setImportFunctionAddress     (int module_index, int         function_index, proc_t new_proc);
 	template <typename proc_t> bool   setImportFunctionAddress     (int module_index, const char* name,           proc_t new_proc);
 	template <typename proc_t> bool   setImportFunctionAddress     (                  const char* name,           proc_t new_proc);
+	template <typename proc_t> proc_t getImportFunctionAddress     (const ProcName <proc_t>& name);
+	template <typename proc_t> bool   setImportFunctionAddress     (const ProcName <proc_t>& name, proc_t new_proc);
 
 	IMAGE_DOS_HEADER*        getDOSEntry    ();
 	IMAGE_NT_HEADERS*        getNTEntry     ();
@@ -48,46 +64,71 @@ public:
 	IMAGE_IMPORT_DESCRIPTOR* getImportEntry ();
 
 protected:
+	// Entry of the open addressing indices of procedure names, built on the
+	// first lookup by ProcName. For exports function_index is the index of
+	// the exported function, module_index is unused.
+	struct NameSlot
+	{
+		uint64_t    hash;
+		const char* name;
+		int         module_index;
+		int         function_index;
+	};
+
 	HMODULE                  m_module;
 	IMAGE_NT_HEADERS*        m_nt_entry;
 	IMAGE_EXPORT_DIRECTORY*  m_export_entry;
 	IMAGE_IMPORT_DESCRIPTOR* m_import_entry;
+	std::vector <NameSlot>   m_export_index;
+	std::vector <NameSlot>   m_import_index;
+
+	const NameSlot* findExport (uint64_t hash, const char* name);
+	const NameSlot* findImport (uint64_t hash, const char* name);
+
+	static void            BuildIndex (std::vector <NameSlot>* index, const std::vector <NameSlot>& names);
+	static const NameSlot* FindName   (const std::vector <NameSlot>& index, uint64_t hash, const char* name);
 
 };
 
 //---------------------
 
-ModuleInfo::ModuleInfo ():
+inline ModuleInfo::ModuleInfo ():
 	BasicModuleInfo (),
 	m_module       (nullptr),
 	m_nt_entry     (nullptr),
 	m_export_entry (nullptr),
-	m_import_entry (nullptr)
+	m_import_entry (nullptr),
+	m_export_index (),
+	m_import_index ()
 {}
 
-ModuleInfo::ModuleInfo (HMODULE module):
+inline ModuleInfo::ModuleInfo (HMODULE module):
 	BasicModuleInfo (),
 	m_module       (nullptr),
 	m_nt_entry     (nullptr),
 	m_export_entry (nullptr),
-	m_import_entry (nullptr)
+	m_import_entry (nullptr),
+	m_export_index (),
+	m_import_index ()
 {
 	load (module);
 }
 
-ModuleInfo::ModuleInfo (const ModuleInfo& copy):
+inline ModuleInfo::ModuleInfo (const ModuleInfo& copy):
 	BasicModuleInfo (),
 	m_module       (nullptr),
 	m_nt_entry     (nullptr),
 	m_export_entry (nullptr),
-	m_import_entry (nullptr)
+	m_import_entry (nullptr),
+	m_export_index (),
+	m_import_index ()
 {
 	load (copy.m_module);
 }
 
 //---------------------
 
-bool ModuleInfo::load (HMODULE module)
+inline bool ModuleInfo::load (HMODULE module)
 {
 	if (!module)
 	{
@@ -97,6 +138,9 @@ bool ModuleInfo::load (HMODULE module)
 
 	m_module = module;
 
+	m_export_index.clear ();
+	m_import_index.clear ();
+
 	IMAGE_DOS_HEADER* dos_header = RVA <IMAGE_DOS_HEADER*> (0);
 	if (!dos_header) return false;
 
@@ -137,7 +181,7 @@ bool ModuleInfo::load (HMODULE module)
 
 //---------------------
 
-bool ModuleInfo::ok () const
+inline bool ModuleInfo::ok () const
 {
 	return !m_has_error && m_module;
 }
@@ -158,21 +202,21 @@ obj_t ModuleInfo::RVA (uintptr_t offset)
 
 //---------------------
 
-HMODULE ModuleInfo::getModuleHandle ()
+inline HMODULE ModuleInfo::getModuleHandle ()
 {
 	return m_module;
 }
 
 //---------------------
 
-const char* ModuleInfo::getOriginalModuleName ()
+inline const char* ModuleInfo::getOriginalModuleName ()
 {
 	return RVA <const char*> (m_export_entry -> Name);
 }
 
 //---------------------
 
-char* ModuleInfo::getModuleFilename (char* buffer, size_t max)
+inline char* ModuleInfo::getModuleFilename (char* buffer, size_t max)
 {
 	GetModuleFileNameA (m_module, buffer, max);
 	return buffer;
@@ -180,36 +224,87 @@ char* ModuleInfo::getModuleFilename (char* buffer, size_t max)
 
 //---------------------
 
-int ModuleInfo::getExportFunctionsCount ()
+inline int ModuleInfo::getExportFunctionsCount ()
 {
 	return m_export_entry -> NumberOfFunctions;
 }
 
 //---------------------
 
-int ModuleInfo::getExportFunctionsNamesCount ()
+inline int ModuleInfo::getExportFunctionsNamesCount ()
 {
 	return m_export_entry -> NumberOfNames;
 }
 
 //---------------------
 
-const char* ModuleInfo::getExportFunctionName (int index)
+inline const char* ModuleInfo::getExportFunctionName (int index)
 {
 	DWORD* names_entry = RVA <DWORD*     > (m_export_entry -> AddressOfNames);
 	return               RVA <const char*> (names_entry[index]              );	
 }
 
-int ModuleInfo::getExportFunctionIndex (const char* name)
+inline int ModuleInfo::getExportFunctionIndex (const char* name)
 {
-	for (size_t i = 0, count = getExportFunctionsCount (); i < count; i++)
-		if (!_stricmp (getExportFunctionName (i), name)) return i;
+	for (size_t i = 0, count = getExportFunctionsNamesCount (); i < count; i++)
+		if (!_stricmp (getExportFunctionName (i), name)) return getExportNameFunctionIndex (i);
 
 	return -1;
 }
 
 //---------------------
 
+// Names are indexed separately from functions, the name ordinals table
+// maps each name to the function it refers to
+
+inline int ModuleInfo::getExportNameFunctionIndex (int name_index)
+{
+	if (name_index < 0 || name_index >= getExportFunctionsNamesCount ())
+	{
+		formatError ("Failed to get export function index: Name index out of range");
+		return -1;
+	}
+
+	WORD* ordinals_entry = RVA <WORD*> (m_export_entry -> AddressOfNameOrdinals);
+	return ordinals_entry[name_index];
+}
+
+inline int ModuleInfo::getExportFunctionOrdinal (int index)
+{
+	if (index < 0 || index >= getExportFunctionsCount ())
+	{
+		formatError ("Failed to get export function ordinal: Index out of range");
+		return -1;
+	}
+
+	return (int) (m_export_entry -> Base + index);
+}
+
+//---------------------
+
+// A function whose address points back into the export directory is
+// forwarded, the address is then the "module.function" it forwards to
+
+inline const char* ModuleInfo::getExportFunctionForwarder (int index)
+{
+	if (index < 0 || index >= getExportFunctionsCount ())
+	{
+		formatError ("Failed to get export function forwarder: Index out of range");
+		return nullptr;
+	}
+
+	IMAGE_DATA_DIRECTORY directory   = m_nt_entry -> OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+	DWORD*               funcs_entry = RVA <DWORD*> (m_export_entry -> AddressOfFunctions);
+
+	DWORD address = funcs_entry[index];
+	if (address < directory.VirtualAddress || address >= directory.VirtualAddress + directory.Size)
+		return nullptr;
+
+	return RVA <const char*> (address);
+}
+
+//---------------------
+
 template <typename proc_t>
 proc_t ModuleInfo::getExportFunctionAddress (int index)
 {
@@ -301,6 +396,41 @@ bool ModuleInfo::setExportFunctionAddress (const char* name, proc_t new_proc)
 	return setExportFunctionAddress (index, new_proc);
 }
 
+//---------------------
+
+template <typename proc_t>
+int ModuleInfo::getExportFunctionIndex (const ProcName <proc_t>& name)
+{
+	const NameSlot* slot = findExport (name.getHash (), name.getName ());
+	return slot? slot -> function_index: -1;
+}
+
+template <typename proc_t>
+proc_t ModuleInfo::getExportFunctionAddress (const ProcName <proc_t>& name)
+{
+	int index = getExportFunctionIndex (name);
+	if (index == -1)
+	{
+		formatError ("Failed to get export function proc address: Specified procedure not found");
+		return nullptr;
+	}
+
+	return getExportFunctionAddress <proc_t> (index);
+}
+
+template <typename proc_t>
+bool ModuleInfo::setExportFunctionAddress (const ProcName <proc_t>& name, proc_t new_proc)
+{
+	int index = getExportFunctionIndex (name);
+	if (index == -1)
+	{
+		formatError ("Failed to set export function proc address: Specified procedure not found");
+		return false;
+	}
+
+	return setExportFunctionAddress (index, new_proc);
+}
+
 /*
  
  	      IMAGE_DOS_HEADER:
@@ -363,7 +493,7 @@ bool ModuleInfo::setExportFunctionAddress (const char* name, proc_t new_proc)
 
 */
 
-int ModuleInfo::getImportModulesCount ()
+inline int ModuleInfo::getImportModulesCount ()
 {
 	int count = 0;
 	for (IMAGE_IMPORT_DESCRIPTOR* desc = m_import_entry; desc -> Name; desc++, count++);
@@ -373,7 +503,7 @@ int ModuleInfo::getImportModulesCount ()
  
 //---------------------
 
-const char* ModuleInfo::getImportModuleName (int index)
+inline const char* ModuleInfo::getImportModuleName (int index)
 {
 	if (index < 0 || index >= getImportModulesCount ())
 	{
@@ -387,7 +517,7 @@ const char* ModuleInfo::getImportModuleName (int index)
 
 //---------------------
 
-int ModuleInfo::getImportModuleIndex (const char* name)
+inline int ModuleInfo::getImportModuleIndex (const char* name)
 {
 	for (size_t i = 0, count = getImportModulesCount (); i < count; i++)
 		if (!_stricmp (getImportModuleName (i), name)) return i;
@@ -397,7 +527,7 @@ int ModuleInfo::getImportModuleIndex (const char* name)
 
 //---------------------
 
-int ModuleInfo::getImportFunctionsCount (int module_index)
+inline int ModuleInfo::getImportFunctionsCount (int module_index)
 {
 	if (module_index < 0 || module_index >= getImportModulesCount ())
 	{
@@ -415,7 +545,7 @@ int ModuleInfo::getImportFunctionsCount (int module_index)
 
 //---------------------
 
-const char* ModuleInfo::getImportFunctionName (int module_index, int function_index)
+inline const char* ModuleInfo::getImportFunctionName (int module_index, int function_index)
 {
 	if (module_index < 0 || module_index >= getImportModulesCount ())
 	{
@@ -431,13 +561,49 @@ const char* ModuleInfo::getImportFunctionName (int module_index, int function_in
 
 	IMAGE_IMPORT_DESCRIPTOR* desc  = m_import_entry + module_index;
 	IMAGE_THUNK_DATA*        thunk = RVA <IMAGE_THUNK_DATA*>     (desc  -> OriginalFirstThunk + function_index * sizeof (IMAGE_THUNK_DATA));
+	if (!desc -> OriginalFirstThunk)
+	{
+		formatError ("Failed to get import function name: Module has no import name table");
+		return nullptr;
+	}
+
+	if (IMAGE_SNAP_BY_ORDINAL (thunk -> u1.Ordinal))
+	{
+		formatError ("Failed to get import function name: Function is imported by ordinal");
+		return nullptr;
+	}
+
 	IMAGE_IMPORT_BY_NAME*    name  = RVA <IMAGE_IMPORT_BY_NAME*> (thunk -> u1.AddressOfData                                               );
 	return name -> Name;
 }
 
 //---------------------
 
-int ModuleInfo::getImportFunctionIndex (int module_index, const char* name)
+inline int ModuleInfo::getImportFunctionOrdinal (int module_index, int function_index)
+{
+	if (module_index < 0 || module_index >= getImportModulesCount ())
+	{
+		formatError ("Failed to get import function ordinal: Module index out of range");
+		return -1;
+	}
+
+	if (function_index < 0 || function_index >= getImportFunctionsCount (module_index))
+	{
+		formatError ("Failed to get import function ordinal: Function index out of range");
+		return -1;
+	}
+
+	IMAGE_IMPORT_DESCRIPTOR* desc  = m_import_entry + module_index;
+	IMAGE_THUNK_DATA*        thunk = RVA <IMAGE_THUNK_DATA*> (desc  -> OriginalFirstThunk + function_index * sizeof (IMAGE_THUNK_DATA));
+	if (!desc -> OriginalFirstThunk || !IMAGE_SNAP_BY_ORDINAL (thunk -> u1.Ordinal))
+		return -1;
+
+	return (int) IMAGE_ORDINAL (thunk -> u1.Ordinal);
+}
+
+//---------------------
+
+inline int ModuleInfo::getImportFunctionIndex (int module_index, const char* name)
 {
 	if (module_index < 0 || module_index >= getImportModulesCount ())
 	{
@@ -446,7 +612,7 @@ int ModuleInfo::getImportFunctionIndex (int module_index, const char* name)
 	}
 
 	for (size_t i = 0, count = getImportFunctionsCount (module_index); i < count; i++)
-		if (!_stricmp (getImportFunctionName (module_index, i), name)) return i;
+		if (getImportFunctionOrdinal (module_index, i) == -1 && !_stricmp (getImportFunctionName (module_index, i), name)) return i;
 
 	return -1;
 }
@@ -501,7 +667,7 @@ proc_t ModuleInfo::getImportFunctionAddress (const char* name)
 {
 	for (size_t module_index = 0, modules_count = getImportModulesCount (); module_index < modules_count; module_index++)
 		for (size_t func_index = 0, funcs_count = getImportFunctionsCount (module_index); func_index < funcs_count; func_index++)
-			if (!_stricmp (getImportFunctionName (module_index, func_index), name)) return getImportFunctionAddress <proc_t> (module_index, func_index);
+			if (getImportFunctionOrdinal (module_index, func_index) == -1 && !_stricmp (getImportFunctionName (module_index, func_index), name)) return getImportFunctionAddress <proc_t> (module_index, func_index);
 
 	formatError ("Failed to get import function index: Specified procedure not found");
 	return nullptr;
@@ -577,7 +743,7 @@ bool ModuleInfo::setImportFunctionAddress (const char* name, proc_t new_proc)
 {
 	for (size_t module_index = 0, modules_count = getImportModulesCount (); module_index < modules_count; module_index++)
 		for (size_t func_index = 0, funcs_count = getImportFunctionsCount (module_index); func_index < funcs_count; func_index++)
-			if (!_stricmp (getImportFunctionName (module_index, func_index), name)) return setImportFunctionAddress <proc_t> (module_index, func_index, new_proc);
+			if (getImportFunctionOrdinal (module_index, func_index) == -1 && !_stricmp (getImportFunctionName (module_index, func_index), name)) return setImportFunctionAddress <proc_t> (module_index, func_index, new_proc);
 
 	formatError ("Failed to set import function index: Specified procedure not found");
 	return false;	
@@ -585,22 +751,143 @@ bool ModuleInfo::setImportFunctionAddress (const char* name, proc_t new_proc)
 
 //---------------------
 
-IMAGE_DOS_HEADER* ModuleInfo::getDOSEntry ()
+template <typename proc_t>
+proc_t ModuleInfo::getImportFunctionAddress (const ProcName <proc_t>& name)
+{
+	const NameSlot* slot = findImport (name.getHash (), name.getName ());
+	if (!slot)
+	{
+		formatError ("Failed to get import function index: Specified procedure not found");
+		return nullptr;
+	}
+
+	return getImportFunctionAddress <proc_t> (slot -> module_index, slot -> function_index);
+}
+
+template <typename proc_t>
+bool ModuleInfo::setImportFunctionAddress (const ProcName <proc_t>& name, proc_t new_proc)
+{
+	const NameSlot* slot = findImport (name.getHash (), name.getName ());
+	if (!slot)
+	{
+		formatError ("Failed to set import function index: Specified procedure not found");
+		return false;
+	}
+
+	return setImportFunctionAddress <proc_t> (slot -> module_index, slot -> function_index, new_proc);
+}
+
+//---------------------
+
+// Both indices hold each name once, the first one in table order, as the
+// lookups by const char* find it
+
+inline const ModuleInfo::NameSlot* ModuleInfo::findExport (uint64_t hash, const char* name)
+{
+	if (m_export_index.empty ())
+	{
+		std::vector <NameSlot> names;
+
+		if (m_nt_entry -> OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress)
+		{
+			DWORD* names_entry    = RVA <DWORD*> (m_export_entry -> AddressOfNames       );
+			WORD*  ordinals_entry = RVA <WORD* > (m_export_entry -> AddressOfNameOrdinals);
+
+			for (DWORD i = 0; i < m_export_entry -> NumberOfNames; i++)
+			{
+				const char* export_name = RVA <const char*> (names_entry[i]);
+				names.push_back ({ProcNameHash (export_name), export_name, -1, ordinals_entry[i]});
+			}
+		}
+
+		BuildIndex (&m_export_index, names);
+	}
+
+	return FindName (m_export_index, hash, name);
+}
+
+inline const ModuleInfo::NameSlot* ModuleInfo::findImport (uint64_t hash, const char* name)
+{
+	if (m_import_index.empty ())
+	{
+		std::vector <NameSlot> names;
+
+		if (m_nt_entry -> OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress)
+		{
+			int module_index = 0;
+			for (IMAGE_IMPORT_DESCRIPTOR* desc = m_import_entry; desc -> Name; desc++, module_index++)
+			{
+				if (!desc -> OriginalFirstThunk) continue;
+
+				int function_index = 0;
+				for (IMAGE_THUNK_DATA* thunk = RVA <IMAGE_THUNK_DATA*> (desc -> OriginalFirstThunk); thunk -> u1.Function; thunk++, function_index++)
+				{
+					if (IMAGE_SNAP_BY_ORDINAL (thunk -> u1.Ordinal)) continue;
+
+					const char* import_name = RVA <IMAGE_IMPORT_BY_NAME*> (thunk -> u1.AddressOfData) -> Name;
+					names.push_back ({ProcNameHash (import_name), import_name, module_index, function_index});
+				}
+			}
+		}
+
+		BuildIndex (&m_import_index, names);
+	}
+
+	return FindName (m_import_index, hash, name);
+}
+
+//---------------------
+
+// At most half full, a lookup mostly ends at the first slot it looks at
+
+inline void ModuleInfo::BuildIndex (std::vector <NameSlot>* index, const std::vector <NameSlot>& names)
+{
+	size_t size = 2;
+	while (size < names.size () * 2)
+		size *= 2;
+
+	index -> assign (size, NameSlot {0, nullptr, -1, -1});
+
+	for (const NameSlot& name: names)
+	{
+		if (FindName (*index, name.hash, name.name)) continue;
+
+		size_t slot = (size_t) name.hash & (size - 1);
+		while ((*index)[slot].name)
+			slot = (slot + 1) & (size - 1);
+
+		(*index)[slot] = name;
+	}
+}
+
+inline const ModuleInfo::NameSlot* ModuleInfo::FindName (const std::vector <NameSlot>& index, uint64_t hash, const char* name)
+{
+	size_t mask = index.size () - 1;
+
+	for (size_t slot = (size_t) hash & mask; index[slot].name; slot = (slot + 1) & mask)
+		if (index[slot].hash == hash && !_stricmp (index[slot].name, name)) return &index[slot];
+
+	return nullptr;
+}
+
+//---------------------
+
+inline IMAGE_DOS_HEADER* ModuleInfo::getDOSEntry ()
 {
 	return RVA <IMAGE_DOS_HEADER*> (0);
 }
 
-IMAGE_NT_HEADERS* ModuleInfo::getNTEntry ()
+inline IMAGE_NT_HEADERS* ModuleInfo::getNTEntry ()
 {
 	return m_nt_entry;
 }
 
-IMAGE_EXPORT_DIRECTORY* ModuleInfo::getExportEntry ()
+inline IMAGE_EXPORT_DIRECTORY* ModuleInfo::getExportEntry ()
 {
 	return m_export_entry;
 }
 
-IMAGE_IMPORT_DESCRIPTOR* ModuleInfo::getImportEntry ()
+inline IMAGE_IMPORT_DESCRIPTOR* ModuleInfo::getImportEntry ()
 {
 	return m_import_entry;
 }
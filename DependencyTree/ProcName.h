@@ -0,0 +1,126 @@
+#pragma once
+
+//---------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+
+#include <Windows.h>
+
+//---------------------
+
+// Case folded FNV-1a of a procedure name. Procedure names are compared
+// with _stricmp, so 'A'..'Z' hash the same as 'a'..'z'.
+
+constexpr uint64_t ProcNameHash (const char* name)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (; *name; name++)
+	{
+		char c = *name;
+		if (c >= 'A' && c <= 'Z')
+			c = (char) (c - 'A' + 'a');
+
+		hash ^= (unsigned char) c;
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
+
+//---------------------
+
+// The name of a procedure, hashed as it is constructed, and the type the
+// procedure is expected to have:
+//
+//     constexpr ProcName <decltype (&CreateFileW)> create_file ("CreateFileW");
+//     auto proc = info.getImportFunctionAddress (create_file);
+//
+// Names are taken as character arrays, not pointers, and are not copied:
+// they have to outlive the ProcName, as string literals do. Declared
+// constexpr, or written as PROC_NAME ("CreateFileW"), the hash is computed
+// by the compiler and a lookup is a single probe of the module's name
+// index.
+
+template <typename proc_t = FARPROC>
+class ProcName
+{
+public:
+	template <size_t size>
+	constexpr ProcName (const char (&name)[size]);
+
+	constexpr const char* getName () const;
+	constexpr uint64_t    getHash () const;
+
+	// The same name, looked up as another type of procedure
+	template <typename other_t> constexpr ProcName <other_t> as () const;
+
+	// What PROC_NAME expands to, the hash comes as a template argument so
+	// that the compiler has to compute it. Any constant is accepted here,
+	// debug builds check that it is the hash of the name.
+	template <size_t size, uint64_t hash>
+	static constexpr ProcName Hashed (const char (&name)[size], std::integral_constant <uint64_t, hash>);
+
+private:
+	template <typename other_t> friend class ProcName;
+
+	// Only ever given a name together with its own hash
+	constexpr ProcName (const char* name, uint64_t hash);
+
+	const char* m_name;
+	uint64_t    m_hash;
+
+};
+
+// The hash goes through a template argument, which has to be a constant
+#define PROC_NAME(literal) ProcName <>::Hashed (literal, std::integral_constant <uint64_t, ProcNameHash (literal)> ())
+
+//---------------------
+
+template <typename proc_t>
+template <size_t size>
+constexpr ProcName <proc_t>::ProcName (const char (&name)[size]):
+	m_name (name),
+	m_hash (ProcNameHash (name))
+{}
+
+template <typename proc_t>
+constexpr ProcName <proc_t>::ProcName (const char* name, uint64_t hash):
+	m_name (name),
+	m_hash (hash)
+{}
+
+template <typename proc_t>
+template <size_t size, uint64_t hash>
+constexpr ProcName <proc_t> ProcName <proc_t>::Hashed (const char (&name)[size], std::integral_constant <uint64_t, hash>)
+{
+	assert (ProcNameHash (name) == hash);
+	return ProcName (name, hash);
+}
+
+//---------------------
+
+template <typename proc_t>
+constexpr const char* ProcName <proc_t>::getName () const
+{
+	return m_name;
+}
+
+template <typename proc_t>
+constexpr uint64_t ProcName <proc_t>::getHash () const
+{
+	return m_hash;
+}
+
+//---------------------
+
+template <typename proc_t>
+template <typename other_t>
+constexpr ProcName <other_t> ProcName <proc_t>::as () const
+{
+	return ProcName <other_t> (m_name, m_hash);
+}
+
+//---------------------
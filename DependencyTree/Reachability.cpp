@@ -0,0 +1,193 @@
+#include <intrin.h>
+#include <emmintrin.h>
+#include <climits>
+#include <algorithm>
+
+#include "Reachability.h"
+
+//--------------------------------
+
+static int LowestBit (uint64_t word)
+{
+	unsigned long index = 0;
+
+	#ifdef _WIN64
+		_BitScanForward64 (&index, word);
+	#else
+		if (!_BitScanForward (&index, (unsigned long) word))
+		{
+			_BitScanForward (&index, (unsigned long) (word >> 32));
+			index += 32;
+		}
+	#endif
+
+	return (int) index;
+}
+
+static void OrWords (uint64_t* dest, const uint64_t* source, int count)
+{
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128i a = _mm_loadu_si128 ((const __m128i*) (dest   + i));
+		__m128i b = _mm_loadu_si128 ((const __m128i*) (source + i));
+		_mm_storeu_si128 ((__m128i*) (dest + i), _mm_or_si128 (a, b));
+	}
+
+	for (; i < count; i++)
+		dest[i] |= source[i];
+}
+
+//--------------------------------
+
+Reachability::Reachability ():
+	m_condensation (),
+	m_descendants  (),
+	m_ancestors    (),
+	m_words        ()
+{}
+
+//--------------------------------
+
+void Reachability::build (const DependencyGraph& graph)
+{
+	m_words.clear ();
+
+	m_condensation.build (graph);
+
+	propagate (m_descendants, true );
+	propagate (m_ancestors,   false);
+}
+
+//--------------------------------
+
+// Descendants are filled from the sinks up (ascending component numbers),
+// ancestors from the sources down, so every set merged into a component
+// is already complete.
+
+void Reachability::propagate (std::vector <Bitset>& sets, bool descendants)
+{
+	int count = m_condensation.getComponentsCount ();
+	sets.assign (count, {0, 0, 0});
+
+	for (int step = 0; step < count; step++)
+	{
+		int c = descendants? step: count - 1 - step;
+
+		const std::vector <int>& edges = descendants? m_condensation.getDependencies (c):
+		                                              m_condensation.getDependents   (c);
+
+		int first = INT_MAX;
+		int last  = -1;
+
+		for (int next: edges)
+		{
+			const Bitset& set = sets[next];
+
+			first = std::min (first, next / 64);
+			last  = std::max (last,  next / 64);
+
+			if (set.words_count)
+			{
+				first = std::min (first, set.first_word);
+				last  = std::max (last,  set.first_word + set.words_count - 1);
+			}
+		}
+
+		if (last < first) continue;
+
+		Bitset& result = sets[c];
+		result.first_word  = first;
+		result.words_count = last - first + 1;
+		result.offset      = m_words.size ();
+
+		m_words.resize (result.offset + result.words_count, 0);
+		uint64_t* words = m_words.data () + result.offset;
+
+		for (int next: edges)
+		{
+			const Bitset& set = sets[next];
+
+			words[next / 64 - first] |= 1ull << (next % 64);
+			if (set.words_count)
+				OrWords (words + (set.first_word - first), m_words.data () + set.offset, set.words_count);
+		}
+	}
+}
+
+//--------------------------------
+
+bool Reachability::test (const Bitset& set, int bit) const
+{
+	int word = bit / 64 - set.first_word;
+	if (word < 0 || word >= set.words_count)
+		return false;
+
+	return (m_words[set.offset + word] >> (bit % 64)) & 1;
+}
+
+void Reachability::collect (const Bitset& set, int exclude, std::vector <int>& modules) const
+{
+	for (int i = 0; i < set.words_count; i++)
+	{
+		for (uint64_t word = m_words[set.offset + i]; word; word &= word - 1)
+		{
+			int        c       = (set.first_word + i) * 64 + LowestBit (word);
+			const int* members = m_condensation.getMembers      (c);
+			int        count   = m_condensation.getMembersCount (c);
+
+			for (int j = 0; j < count; j++)
+				if (members[j] != exclude) modules.push_back (members[j]);
+		}
+	}
+}
+
+//--------------------------------
+
+bool Reachability::reaches (int from, int to) const
+{
+	int source = m_condensation.getComponent (from);
+	int target = m_condensation.getComponent (to  );
+
+	if (source == target) return true;
+	return test (m_descendants[source], target);
+}
+
+//--------------------------------
+
+std::vector <int> Reachability::getDependencies (int module) const
+{
+	int        c       = m_condensation.getComponent    (module);
+	const int* members = m_condensation.getMembers      (c);
+	int        count   = m_condensation.getMembersCount (c);
+
+	std::vector <int> modules;
+	for (int j = 0; j < count; j++)
+		if (members[j] != module) modules.push_back (members[j]);
+
+	collect (m_descendants[c], module, modules);
+	return modules;
+}
+
+std::vector <int> Reachability::getDependents (int module) const
+{
+	int        c       = m_condensation.getComponent    (module);
+	const int* members = m_condensation.getMembers      (c);
+	int        count   = m_condensation.getMembersCount (c);
+
+	std::vector <int> modules;
+	for (int j = 0; j < count; j++)
+		if (members[j] != module) modules.push_back (members[j]);
+
+	collect (m_ancestors[c], module, modules);
+	return modules;
+}
+
+//--------------------------------
+
+const Condensation& Reachability::getCondensation () const
+{
+	return m_condensation;
+}
+
+//--------------------------------
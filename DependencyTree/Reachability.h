@@ -0,0 +1,56 @@
+#pragma once
+
+//--------------------------------
+
+#include <vector>
+#include <cstdint>
+
+#include "DependencyGraph.h"
+#include "Condensation.h"
+
+//--------------------------------
+
+// Transitive closure index over a finished scan.
+//
+// The index is built over the condensed DAG. Condensation numbers
+// components in reverse topological order, which means the descendants
+// of component c all lie below c and its ancestors above it.
+// Each component keeps two bitsets that only cover the word span actually
+// populated, and they are filled with one OR pass over the DAG.
+
+class Reachability
+{
+public :
+	Reachability ();
+
+	void build (const DependencyGraph& graph);
+
+	bool reaches (int from, int to) const;
+
+	std::vector <int> getDependencies (int module) const;
+	std::vector <int> getDependents   (int module) const;
+
+	const Condensation& getCondensation () const;
+
+private :
+	struct Bitset
+	{
+		int    first_word;
+		int    words_count;
+		size_t offset;
+	};
+
+	Condensation           m_condensation;
+
+	std::vector <Bitset>   m_descendants;
+	std::vector <Bitset>   m_ancestors;
+	std::vector <uint64_t> m_words;
+
+	void propagate (std::vector <Bitset>& sets, bool descendants);
+
+	bool test    (const Bitset& set, int bit) const;
+	void collect (const Bitset& set, int exclude, std::vector <int>& modules) const;
+
+};
+
+//--------------------------------
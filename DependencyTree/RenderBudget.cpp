@@ -0,0 +1,243 @@
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+#include "RenderBudget.h"
+#include "Reachability.h"
+
+//--------------------------------
+
+RenderBudget::RenderBudget ():
+	m_max_depth       (INT_MAX),
+	m_max_nodes       (500),
+	m_max_edges       (2000),
+	m_groups          (),
+	m_collapse_system (false)
+{}
+
+//--------------------------------
+
+void RenderBudget::setMaxDepth (int depth)
+{
+	m_max_depth = depth;
+}
+
+void RenderBudget::setMaxNodes (int nodes)
+{
+	m_max_nodes = nodes;
+}
+
+void RenderBudget::setMaxEdges (int edges)
+{
+	m_max_edges = edges;
+}
+
+//--------------------------------
+
+void RenderBudget::addGroup (const char* prefix, const char* label)
+{
+	m_groups.push_back ({prefix, label});
+}
+
+void RenderBudget::collapseSystem (bool collapse)
+{
+	m_collapse_system = collapse;
+}
+
+//--------------------------------
+
+// Returns the index of the group the module belongs to, the system
+// group comes right after the prefix groups. Roots are never collapsed.
+
+int RenderBudget::findGroup (const DependencyGraph& scan, int module) const
+{
+	unsigned flags = scan.getFlags (module);
+	if (flags & DependencyGraph::Root)
+		return -1;
+
+	const char* name = scan.getModuleName (module);
+	for (size_t i = 0; i < m_groups.size (); i++)
+		if (_strnicmp (name, m_groups[i].prefix.c_str (), m_groups[i].prefix.size ()) == 0) return (int) i;
+
+	if (m_collapse_system && (flags & DependencyGraph::System))
+		return (int) m_groups.size ();
+
+	return -1;
+}
+
+//--------------------------------
+
+std::vector <int> RenderBudget::measureDepth (const DependencyGraph& scan) const
+{
+	int count = scan.getModulesCount ();
+
+	std::vector <int> depth (count, -1);
+	std::vector <int> queue;
+
+	for (int module = 0; module < count; module++)
+		if (scan.getFlags (module) & DependencyGraph::Root) queue.push_back (module);
+
+	if (queue.empty ())
+		for (int module = 0; module < count; module++)
+			if (scan.getDependents (module).empty ()) queue.push_back (module);
+
+	for (int module: queue)
+		depth[module] = 0;
+
+	for (size_t i = 0; i < queue.size (); i++)
+	{
+		for (int dependency: scan.getDependencies (queue[i]))
+		{
+			if (depth[dependency] != -1) continue;
+
+			depth[dependency] = depth[queue[i]] + 1;
+			queue.push_back (dependency);
+		}
+	}
+
+	for (int& level: depth)
+		if (level == -1) level = 0;
+
+	return depth;
+}
+
+//--------------------------------
+
+void RenderBudget::collapse (const DependencyGraph& scan, const std::vector <int>& depth, int max_depth, DependencyGraph* result) const
+{
+	int count        = scan.getModulesCount ();
+	int groups_count = (int) m_groups.size () + 1;
+
+	std::vector <int> group   (count,        -1);
+	std::vector <int> members (groups_count,  0);
+
+	for (int module = 0; module < count; module++)
+	{
+		if (depth[module] > max_depth) continue;
+
+		group[module] = findGroup (scan, module);
+		if (group[module] != -1)
+			members[group[module]]++;
+	}
+
+	std::vector <int> supernode (groups_count, -1);
+	std::vector <int> target    (count,        -1);
+
+	for (int module = 0; module < count; module++)
+	{
+		if (depth[module] > max_depth) continue;
+
+		int index = group[module];
+		if (index == -1)
+		{
+			target[module] = result -> addModule (scan.getModuleName (module));
+			result -> addFlags (target[module], scan.getFlags (module) & ~DependencyGraph::Visited);
+			continue;
+		}
+
+		if (supernode[index] == -1)
+		{
+			std::string label = index < (int) m_groups.size ()? m_groups[index].label: "system";
+			label += " (" + std::to_string (members[index]) + ")";
+
+			supernode[index] = result -> addModule (label.c_str ());
+			result -> addFlags (supernode[index], DependencyGraph::Group);
+		}
+
+		target[module] = supernode[index];
+	}
+
+	for (int from = 0; from < count; from++)
+	{
+		if (target[from] == -1) continue;
+
+		for (int to: scan.getDependencies (from))
+		{
+			if (target[to] == -1) continue;
+
+			bool self_import = from == to && group[from] == -1;
+			if (target[from] != target[to] || self_import)
+				result -> addEdge (target[from], target[to]);
+		}
+	}
+}
+
+//--------------------------------
+
+// Transitive reduction on the condensed DAG: an edge u -> v is implied
+// when another dependency w of u, outside of v's component, reaches v.
+// Edges inside a cycle are kept as they are.
+
+void RenderBudget::simplify (const DependencyGraph& graph, DependencyGraph* result) const
+{
+	Reachability reachability;
+	reachability.build (graph);
+
+	const Condensation& condensation = reachability.getCondensation ();
+
+	int count = graph.getModulesCount ();
+	for (int module = 0; module < count; module++)
+		result -> addFlags (result -> addModule (graph.getModuleName (module)), graph.getFlags (module));
+
+	for (int from = 0; from < count; from++)
+	{
+		const std::vector <int>& dependencies = graph.getDependencies (from);
+		int                      component    = condensation.getComponent (from);
+
+		for (int to: dependencies)
+		{
+			bool implied = false;
+			if (condensation.getComponent (to) != component)
+			{
+				for (int via: dependencies)
+				{
+					int via_component = condensation.getComponent (via);
+					if (via_component == component || via_component == condensation.getComponent (to)) continue;
+
+					if (reachability.reaches (via, to))
+					{
+						implied = true;
+						break;
+					}
+				}
+			}
+
+			if (!implied)
+				result -> addEdge (from, to);
+		}
+	}
+}
+
+//--------------------------------
+
+void RenderBudget::reduce (const DependencyGraph& scan, DependencyGraph* result) const
+{
+	std::vector <int> depth = measureDepth (scan);
+
+	int deepest   = depth.empty ()? 0: *std::max_element (depth.begin (), depth.end ());
+	int max_depth = std::min (m_max_depth, deepest);
+
+	DependencyGraph collapsed;
+	for (;;)
+	{
+		collapsed.clear ();
+		result -> clear ();
+
+		collapse (scan, depth, max_depth, &collapsed);
+		simplify (collapsed, result);
+
+		bool fits = result -> getModulesCount () <= m_max_nodes && result -> getEdgesCount () <= m_max_edges;
+		if (fits) break;
+
+		if (max_depth <= 1)
+		{
+			printf ("Warning: Render budget exceeded even at depth 1 (%d nodes, %d edges)\n", result -> getModulesCount (), result -> getEdgesCount ());
+			break;
+		}
+
+		max_depth--;
+	}
+}
+
+//--------------------------------
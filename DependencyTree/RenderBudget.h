@@ -0,0 +1,57 @@
+#pragma once
+
+//--------------------------------
+
+#include <string>
+#include <vector>
+
+#include "DependencyGraph.h"
+
+//--------------------------------
+
+// Reduction stage run on a finished scan before it is handed to dot.
+//
+// Modules deeper than the depth cap are dropped, configured groups
+// (system modules, name prefixes such as API sets or vendor DLLs) are
+// collapsed into one supernode each, and edges implied by longer paths
+// are removed. If the result still exceeds the node or edge budget the
+// depth cap is lowered until it fits, so layout time stays bounded no
+// matter how large the scan was.
+
+class RenderBudget
+{
+public :
+	RenderBudget ();
+
+	void setMaxDepth (int depth);
+	void setMaxNodes (int nodes);
+	void setMaxEdges (int edges);
+
+	void addGroup       (const char* prefix, const char* label);
+	void collapseSystem (bool collapse);
+
+	void reduce (const DependencyGraph& scan, DependencyGraph* result) const;
+
+private :
+	struct Group
+	{
+		std::string prefix;
+		std::string label;
+	};
+
+	int                 m_max_depth;
+	int                 m_max_nodes;
+	int                 m_max_edges;
+	std::vector <Group> m_groups;
+	bool                m_collapse_system;
+
+	int findGroup (const DependencyGraph& scan, int module) const;
+
+	std::vector <int> measureDepth (const DependencyGraph& scan) const;
+
+	void collapse (const DependencyGraph& scan, const std::vector <int>& depth, int max_depth, DependencyGraph* result) const;
+	void simplify (const DependencyGraph& graph, DependencyGraph* result) const;
+
+};
+
+//--------------------------------
@@ -2,118 +2,624 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <future>
 
 #include <Windows.h>
 #include "BasicModuleInfo.h"
 #include "ModuleInfo.h"
 #include "Graph.h"
+#include "DependencyGraph.h"
+#include "Condensation.h"
+#include "Reachability.h"
+#include "GraphDiff.h"
+#include "Exporter.h"
+#include "RenderBudget.h"
+#include "Traversal.h"
+#include "ImageCache.h"
+#include "ExportDatabase.h"
+#include "HeaderReader.h"
+#include "ImportAnalytics.h"
 
 //------------------------
 
-#define RECURSION_LIMIT 32
+void SetupGraph (Graph* graph);
+int  ShowGraph  (Graph* graph, int result);
+
+bool ExpandModule   (ImageCache* cache, DependencyGraph* scan, int module, std::vector <std::string>* dependencies);
+bool IsSystemModule (const char* path);
+void DumpCycles     (Graph* graph, const DependencyGraph& scan);
+void DumpImpact     (const DependencyGraph& scan, const char* dllname);
+int  DumpDiff       (const char* before, const char* after, const char* renderer);
+int  ReadSummaries  (const std::vector <std::string>& files, int in_flight, std::vector <std::shared_ptr <const ModuleSummary>>* summaries);
+int  BuildExports   (const char* database, const std::vector <const char*>& paths, int in_flight);
+int  AnalyzeImports (const std::vector <const char*>& paths, int in_flight, int top);
+int  FindExport     (const char* database, const char* symbol);
+void CollectImages  (const char* path, std::vector <std::string>* files);
 
 //------------------------
 
-bool DumpDependencies (Graph* graph, const char* dllname, const char* parent = nullptr, int recursion = 0);
+int main (int argc, char* argv[])
+{
+	std::vector <const char*> roots;
+	const char* impact = nullptr;
+	const char* save   = nullptr;
+
+	const char* checkpoint = nullptr;
+	const char* resume     = nullptr;
+	int         interval   = 64;
+
+	Traversal::Order order = Traversal::DepthFirst;
+
+	const char* diff_before = nullptr;
+	const char* diff_after  = nullptr;
+
+	const char* find_database = nullptr;
+	const char* find_symbol   = nullptr;
+
+	const char* exports_database = nullptr;
+	int         in_flight        = HeaderReader::DefaultMaxInFlight;
+
+	bool analyze = false;
+	int  top     = 20;
+
+	int      max_mappings = MappingManager::DefaultMaxMappings;
+	uint64_t max_mapped   = MappingManager::DefaultMaxBytes;
+
+	const char* renderer  = DOT_PATH;
+	bool        streaming = false;
+	bool        keep_file = true;
+
+	std::vector <std::unique_ptr <Exporter>> exporters;
+
+	RenderBudget budget;
+	bool         budgeted = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp (argv[i], "--impact") == 0 && i+1 < argc)
+			impact = argv[++i];
+
+		else if (strcmp (argv[i], "--save") == 0 && i+1 < argc)
+			save = argv[++i];
+
+		else if (strcmp (argv[i], "--order") == 0 && i+1 < argc)
+		{
+			const char* name = argv[++i];
+
+			if      (strcmp (name, "bfs"  ) == 0) order = Traversal::BreadthFirst;
+			else if (strcmp (name, "dfs"  ) == 0) order = Traversal::DepthFirst;
+			else if (strcmp (name, "level") == 0) order = Traversal::LevelOrder;
+
+			else
+			{
+				printf ("Warning: Unknown traversal order '%s'\n", name);
+				return -1;
+			}
+		}
+
+		else if (strcmp (argv[i], "--checkpoint") == 0 && i+1 < argc)
+			checkpoint = argv[++i];
+
+		else if (strcmp (argv[i], "--checkpoint-interval") == 0 && i+1 < argc)
+			interval = atoi (argv[++i]);
+
+		else if (strcmp (argv[i], "--resume") == 0 && i+1 < argc)
+			resume = argv[++i];
+
+		else if (strcmp (argv[i], "--renderer") == 0 && i+1 < argc)
+			renderer = argv[++i];
+
+		else if (strcmp (argv[i], "--stream") == 0)
+			streaming = true;
+
+		else if (strcmp (argv[i], "--no-graph-file") == 0)
+			keep_file = false;
+
+		else if (strcmp (argv[i], "--diff") == 0 && i+2 < argc)
+		{
+			diff_before = argv[++i];
+			diff_after  = argv[++i];
+		}
+
+		else if (strcmp (argv[i], "--max-mappings") == 0 && i+1 < argc)
+			max_mappings = atoi (argv[++i]);
+
+		else if (strcmp (argv[i], "--max-mapped") == 0 && i+1 < argc)
+			max_mapped = (uint64_t) atoi (argv[++i]) * 1024 * 1024;
+
+		else if (strcmp (argv[i], "--build-exports") == 0 && i+1 < argc)
+			exports_database = argv[++i];
+
+		else if (strcmp (argv[i], "--in-flight") == 0 && i+1 < argc)
+			in_flight = atoi (argv[++i]);
+
+		else if (strcmp (argv[i], "--analyze") == 0)
+			analyze = true;
+
+		else if (strcmp (argv[i], "--top") == 0 && i+1 < argc)
+			top = atoi (argv[++i]);
+
+		else if (strcmp (argv[i], "--find-export") == 0 && i+2 < argc)
+		{
+			find_database = argv[++i];
+			find_symbol   = argv[++i];
+		}
+
+		else if (strcmp (argv[i], "--export") == 0 && i+2 < argc)
+		{
+			Exporter* exporter = Exporter::Create (argv[i+1], argv[i+2]);
+			if (!exporter) return -1;
+
+			exporters.emplace_back (exporter);
+			i += 2;
+		}
+
+		else if (strcmp (argv[i], "--budget") == 0 && i+1 < argc)
+		{
+			int nodes = atoi (argv[++i]);
+			budget.setMaxNodes (nodes);
+			budget.setMaxEdges (nodes * 4);
+			budgeted = true;
+		}
+
+		else if (strcmp (argv[i], "--depth") == 0 && i+1 < argc)
+		{
+			budget.setMaxDepth (atoi (argv[++i]));
+			budgeted = true;
+		}
+
+		else if (strcmp (argv[i], "--collapse") == 0 && i+1 < argc)
+		{
+			const char* prefix = argv[++i];
+			if (strcmp (prefix, "system") == 0)
+				budget.collapseSystem (true);
+
+			else budget.addGroup (prefix, (std::string (prefix) + "*").c_str ());
+			budgeted = true;
+		}
+
+		else roots.push_back (argv[i]);
+	}
+
+	// Modes are only dispatched once every option has been read
+	if (diff_before)
+		return DumpDiff (diff_before, diff_after, renderer);
+
+	if (find_database)
+		return FindExport (find_database, find_symbol);
+
+	// Positional arguments are the corpus to index rather than roots
+	if (exports_database)
+		return BuildExports (exports_database, roots, in_flight);
+
+	if (analyze)
+		return AnalyzeImports (roots, in_flight, top);
+
+	if (budgeted)
+	{
+		budget.addGroup ("api-ms-win-", "api-ms-win-*");
+		budget.addGroup ("ext-ms-",     "ext-ms-*"    );
+	}
+
+	if (roots.empty () && !resume)
+		roots.push_back ("notepad.exe");
+
+	// A resumed scan keeps checkpointing into the file it came from
+	if (resume && !checkpoint)
+		checkpoint = resume;
+
+	Graph graph ("dependencies");
+	graph.setRenderer (renderer);
+
+	if (!graph.available ())
+	{
+		printf ("Warning: Renderer '%s' was not found\n", renderer);
+		return -1;
+	}
+
+	if (streaming && !graph.stream (keep_file))
+		printf ("Warning: Failed to start '%s', the graph will be rendered after the scan\n", renderer);
+
+	SetupGraph (&graph);
+
+	DotExporter dot (&graph);
+	TeeExporter tee;
+
+	if (!budgeted)
+		tee.attach (&dot);
+
+	for (auto& exporter: exporters)
+		tee.attach (exporter.get ());
+
+	DependencyGraph scan;
+	ImageCache      cache;
+
+	cache.getMappings () -> setBudget (max_mappings, max_mapped);
+
+	Traversal traversal (&scan, &tee, [&cache] (DependencyGraph* scan, int module, std::vector <std::string>* dependencies)
+	{
+		return ExpandModule (&cache, scan, module, dependencies);
+	});
+	traversal.setOrder (order);
+
+	if (checkpoint)
+		traversal.setCheckpoint (checkpoint, interval);
+
+	if (resume && !traversal.resume (resume))
+		return -1;
+
+	for (const char* root: roots)
+		traversal.addRoot (root);
+
+	traversal.run ();
+
+	if (traversal.getFailedCount ())
+		printf ("Warning: %d of %d module(s) failed to expand\n", traversal.getFailedCount (), traversal.getExpandedCount ());
+
+	printf ("Parsed %d unique image(s) for %d file(s)\n", cache.getImagesCount (), cache.getFilesCount ());
+
+	MappingManager* mappings = cache.getMappings ();
+	printf ("Mapped at most %llu MB, %d mapping(s) evicted\n", (unsigned long long) (mappings -> getPeakBytes () >> 20), mappings -> getEvictionsCount ());
+	mappings -> clear ();
+
+	exporters.clear ();
+
+	if (budgeted)
+	{
+		DependencyGraph reduced;
+		budget.reduce (scan, &reduced);
+
+		printf ("Render budget: %d modules and %d edges reduced to %d nodes and %d edges\n",
+		        scan   .getModulesCount (), scan   .getEdgesCount (),
+		        reduced.getModulesCount (), reduced.getEdgesCount ());
+
+		dot.replay (reduced);
+		DumpCycles (&graph, reduced);
+	}
+
+	else DumpCycles (&graph, scan);
+
+	// Layout runs in the background while the remaining reports are made
+	std::future <int> rendering = graph.renderAsync ();
+
+	if (impact)
+		DumpImpact (scan, impact);
+
+	if (save)
+		scan.save (save);
+
+	return ShowGraph (&graph, rendering.get ());
+}
 
 //------------------------
 
-int main ()
+void SetupGraph (Graph* graph)
+{
+	graph -> add ("dpi = 200;");
+	graph -> add ("bgcolor = \"#181818\"");
+	graph -> add ("splines = ortho;");
+	graph -> add ("ranksep = 2;");
+	graph -> add ("");
+	graph -> add ("node [shape = signature, color = white, fontcolor = white, fontname = consolas]");
+	graph -> add ("edge [color = white, fillcolor = white]");
+	graph -> add ("");
+}
+
+int ShowGraph (Graph* graph, int result)
 {
-	Graph graph ("dependencies");
-	graph.add ("dpi = 200;");
-	graph.add ("bgcolor = \"#181818\"");
-	graph.add ("splines = ortho;");
-	graph.add ("ranksep = 2;");
-	graph.add ("");
-	graph.add ("node [shape = signature, color = white, fontcolor = white, fontname = consolas]");
-	graph.add ("edge [color = white, fillcolor = white]");
-	graph.add ("");
-
-	DumpDependencies (&graph, "notepad.exe");
-
-	int result = graph.render ();
 	if (result == 0)
 	{
 		char cmd[BUFFSIZE] = "";
-		sprintf_s (cmd, "start %s", graph.image.c_str ());
+		sprintf_s (cmd, "start %s", graph -> image.c_str ());
 		system (cmd);
 	}
 
-	else printf ("dot.exe exited with error 0x%08X (%d)\n", result, result);
+	else printf ("%s exited with error 0x%08X (%d)\n", graph -> getRenderer ().c_str (), result, result);
+
+	return result;
 }
 
 //------------------------
 
-bool DumpDependencies (Graph* graph, const char* dllname, const char* parent /*= nullptr*/, int recursion /*= 0*/)
+// Resolves a module to its file and records what the scan needs from
+// it. Identical files reached through different paths share one parse.
+
+bool ExpandModule (ImageCache* cache, DependencyGraph* scan, int module, std::vector <std::string>* dependencies)
 {
-	if (recursion >= RECURSION_LIMIT)
+	const char* dllname = scan -> getModuleName (module);
+
+	char path[MAX_PATH] = "";
+	if (!cache -> locate (dllname, path, MAX_PATH))
 	{
-		printf ("Warning: Recursion calls limit exceeded (%d)\n", recursion);
+		scan -> addFlags (module, DependencyGraph::Missing);
+
+		printf ("Warning: Failed to find module '%s': %s\n", dllname, FormatWinapiError (GetLastError ()));
+		return true;
+	}
+
+	std::shared_ptr <const ModuleSummary> summary = cache -> get (path);
+	if (!summary)
 		return false;
+
+	// Shares the cached list, the summary is kept alive by the graph
+	scan -> setImports (module, DependencyGraph::Imports (summary, &summary -> imports));
+	cache -> locateDependencies (path, *summary);
+
+	if (IsSystemModule (path))
+		scan -> addFlags (module, DependencyGraph::System);
+
+	if (_stricmp (dllname, "NTDLL.DLL") == 0)
+		scan -> addFlags (module, DependencyGraph::Terminal);
+
+	else *dependencies = summary -> dependencies;
+
+	return true;
+}
+
+//------------------------
+
+bool IsSystemModule (const char* path)
+{
+	static char system_dir[MAX_PATH] = "";
+	static UINT length = GetSystemDirectoryA (system_dir, MAX_PATH);
+
+	return length && _strnicmp (path, system_dir, length) == 0 && path[length] == '\\';
+}
+
+//------------------------
+
+void DumpCycles (Graph* graph, const DependencyGraph& scan)
+{
+	Condensation condensation;
+	condensation.build (scan);
+
+	std::vector <int> cycles = condensation.getCycles ();
+	for (size_t i = 0; i < cycles.size (); i++)
+	{
+		int        component = cycles[i];
+		const int* members   = condensation.getMembers      (component);
+		int        count     = condensation.getMembersCount (component);
+
+		printf ("Warning: Dependency cycle %zu (%d module(s)):", i, count);
+		for (int j = 0; j < count; j++)
+			printf (" %s", scan.getModuleName (members[j]));
+		printf ("\n");
+
+		// Self imports are already highlighted by DotExporter
+		if (count < 2) continue;
+
+		graph -> add ("");
+		graph -> add ("subgraph cluster_cycle_%zu", i);
+		graph -> add ("{");
+		graph -> add ("label = \"cycle %zu\";", i);
+		graph -> add ("color = \"#FFFF00\";");
+		graph -> add ("fontcolor = \"#FFFF00\";");
+
+		for (int j = 0; j < count; j++)
+			graph -> add ("\"%s\";", scan.getModuleName (members[j]));
+
+		graph -> add ("}");
+
+		for (int j = 0; j < count; j++)
+			for (int dependency: scan.getDependencies (members[j]))
+				if (condensation.getComponent (dependency) == component)
+					graph -> edge (scan.getModuleName (members[j]), scan.getModuleName (dependency), {{"color", "\"#FFFF00\""}, {"fillcolor", "\"#FFFF00\""}}, DotExporter::Cycle);
 	}
+}
+
+//------------------------
 
-	if (parent && (dllname == parent || strcmp (dllname, parent) == 0))
+void DumpImpact (const DependencyGraph& scan, const char* dllname)
+{
+	int module = scan.findModule (dllname);
+	if (module == -1)
 	{
-		graph -> add ("\"%s\" [style = filled, fillcolor = \"#464513\", label = \"%s\"];", dllname, dllname);
-		graph -> add ("\"%s\" -> \"%s\" [color = \"#FFFF00\", fillcolor = \"#FFFF00\"];", dllname, parent);
-		return false;
+		printf ("Warning: Module '%s' was not found in the scan\n", dllname);
+		return;
 	}
 
-	HMODULE module = LoadLibraryA (dllname);
-	if (!module)
+	Reachability reachability;
+	reachability.build (scan);
+
+	std::vector <int> dependents = reachability.getDependents (module);
+	printf ("%zu module(s) depend on '%s':\n", dependents.size (), scan.getModuleName (module));
+
+	for (int dependent: dependents)
+		printf ("    %s%s\n", scan.getModuleName (dependent), scan.getFlags (dependent) & DependencyGraph::Root? " (root)": "");
+}
+
+//------------------------
+
+int DumpDiff (const char* before, const char* after, const char* renderer)
+{
+	DependencyGraph old_scan;
+	DependencyGraph new_scan;
+
+	if (!old_scan.load (before) || !new_scan.load (after))
+		return -1;
+
+	GraphDiff diff;
+	diff.compare (old_scan, new_scan);
+	diff.report  (stdout);
+
+	Graph graph ("diff");
+	graph.setRenderer (renderer);
+
+	if (!graph.available ())
 	{
-		graph -> add ("\"%s\" [style = filled, fillcolor = \"#5E1B1B\", label = \"%s\"];", dllname, dllname);
-		if (parent)
-			graph -> add ("\"%s\" -> \"%s\" [color = \"#5e1b1b\", fillcolor = \"#FF0000\"];", parent, dllname);
+		printf ("Warning: Renderer '%s' was not found\n", renderer);
+		return -1;
+	}
 
-		printf ("Warning: Failed to load library '%s': %s\n", dllname, FormatWinapiError (GetLastError ()));
-		return true;
+	SetupGraph (&graph);
+
+	diff.draw (&graph);
+	return ShowGraph (&graph, graph.render ());
+}
+
+//------------------------
+
+// Only the headers and directories of PE files are read, many files at
+// a time. Whatever the reader can't handle, ELF files to begin with, is
+// parsed in full by an ImageCache. Returns the number of files parsed in
+// full; summaries of files that couldn't be read at all are nullptr.
+
+int ReadSummaries (const std::vector <std::string>& files, int in_flight, std::vector <std::shared_ptr <const ModuleSummary>>* summaries)
+{
+	HeaderReader reader;
+	reader.setMaxInFlight (in_flight);
+
+	for (const std::string& file: files)
+		reader.add (file.c_str ());
+
+	summaries -> assign (files.size (), nullptr);
+	reader.run ([summaries] (int index, const char* path, std::shared_ptr <const ModuleSummary> summary)
+	{
+		(*summaries)[index] = summary;
+	});
+
+	printf ("Read %llu KB of headers in %d read(s) over %d round(s)%s\n", (unsigned long long) (reader.getBytesRead () >> 10), reader.getReadsCount (), reader.getRoundsCount (), in_flight > 0? "": ", one file at a time");
+
+	ImageCache cache;
+	for (size_t i = 0; i < files.size (); i++)
+		if (!(*summaries)[i])
+			(*summaries)[i] = cache.get (files[i].c_str ());
+
+	return cache.getImagesCount ();
+}
+
+//------------------------
+
+int BuildExports (const char* database, const std::vector <const char*>& paths, int in_flight)
+{
+	std::vector <std::string> files;
+	for (const char* path: paths)
+		CollectImages (path, &files);
+
+	std::vector <std::shared_ptr <const ModuleSummary>> summaries;
+	int parsed = ReadSummaries (files, in_flight, &summaries);
+
+	ExportDatabaseBuilder builder;
+	for (size_t i = 0; i < files.size (); i++)
+		if (summaries[i])
+			builder.add (files[i].c_str (), *summaries[i]);
+
+	if (!builder.write (database))
+		return -1;
+
+	printf ("Indexed %d symbol(s) from %d module(s) (%d parsed in full) into '%s'\n", builder.getSymbolsCount (), builder.getModulesCount (), parsed, database);
+	return 0;
+}
+
+//------------------------
+
+int AnalyzeImports (const std::vector <const char*>& paths, int in_flight, int top)
+{
+	std::vector <std::string> files;
+	for (const char* path: paths)
+		CollectImages (path, &files);
+
+	std::vector <std::shared_ptr <const ModuleSummary>> summaries;
+	ReadSummaries (files, in_flight, &summaries);
+
+	ImportAnalytics analytics;
+	for (size_t i = 0; i < files.size (); i++)
+		if (summaries[i])
+			analytics.add (files[i].c_str (), summaries[i]);
+
+	if (!analytics.getModulesCount ())
+	{
+		printf ("Warning: No modules to analyze\n");
+		return -1;
 	}
-												
-	ModuleInfo info;
-	if (!info.load (module))
+
+	analytics.run ();
+	analytics.report (stdout, top);
+	return 0;
+}
+
+//------------------------
+
+int FindExport (const char* database, const char* symbol)
+{
+	ExportDatabase exports;
+	if (!exports.open (database))
+		return -1;
+
+	int found = exports.find (symbol);
+	if (found == -1)
 	{
-		FreeLibrary (module);
+		printf ("'%s' is not exported by any indexed module\n", symbol);
+		return 1;
+	}
 
-		printf ("%s\n", info.getError ());
-		return false;
+	for (const ExportDatabase::Export& entry: exports.getExports (found))
+	{
+		// ELF exports have no ordinal
+		if      (entry.forwarder) printf ("%s @%d -> %s\n", entry.module, entry.ordinal, entry.forwarder);
+		else if (entry.ordinal)   printf ("%s @%d\n",       entry.module, entry.ordinal);
+		else                      printf ("%s\n",           entry.module);
 	}
 
-	if (parent)
-		graph -> add ("\"%s\" -> \"%s\"", parent, dllname);
+	return 0;
+}
 
-	else graph -> add ("\"%s\" [style = filled, fillcolor = \"#12304D\"]", dllname);
+//------------------------
 
-	if (_stricmp (dllname, "NTDLL.DLL") == 0)
+// Expands a corpus argument into image files: directories are walked for
+// .dll and .exe files, anything that is not a path is resolved as a
+// module name.
+
+void CollectImages (const char* path, std::vector <std::string>* files)
+{
+	DWORD attributes = GetFileAttributesA (path);
+	if (attributes == INVALID_FILE_ATTRIBUTES)
 	{
-		graph -> add ("\"%s\" [style = filled, fillcolor = \"#13463C\"]", dllname);
+		char resolved[MAX_PATH] = "";
+		if (ImageCache::Resolve (path, resolved, MAX_PATH))
+			files -> push_back (resolved);
 
-		FreeLibrary (module);
-		return true;
+		else printf ("Warning: Failed to find '%s'\n", path);
+		return;
+	}
+
+	if (!(attributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		files -> push_back (path);
+		return;
 	}
 
-	int count = info.getImportModulesCount ();
-	for (size_t i = 0; i < count; i++)
+	std::vector <std::string> directories (1, path);
+	while (!directories.empty ())
 	{
-		for (size_t j = 0; j < i; j++)
+		std::string directory = directories.back ();
+		directories.pop_back ();
+
+		WIN32_FIND_DATAA data = {};
+		HANDLE find = FindFirstFileA ((directory + "\\*").c_str (), &data);
+		if (find == INVALID_HANDLE_VALUE) continue;
+
+		do
 		{
-			if (strcmp (info.getImportModuleName (j), info.getImportModuleName (i)) == 0)
+			if (!strcmp (data.cFileName, ".") || !strcmp (data.cFileName, "..")) continue;
+
+			std::string child = directory + "\\" + data.cFileName;
+			if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 			{
-				FreeLibrary (module);
-				return true;
+				directories.push_back (child);
+				continue;
 			}
-		}
 
-		if (!DumpDependencies (graph, info.getImportModuleName (i), dllname, recursion+1))
-		{
-			FreeLibrary (module);
-			return false;
-		}
-	}
+			// Shared objects are versioned as libname.so.1.2
+			const char* extension     = strrchr (data.cFileName, '.');
+			const char* shared_object = strstr  (data.cFileName, ".so");
 
-	FreeLibrary (module);
-	return true;
-}
+			if ((extension && (!_stricmp (extension, ".dll") || !_stricmp (extension, ".exe"))) ||
+			    (shared_object && (shared_object[3] == '\0' || shared_object[3] == '.')))
+				files -> push_back (child);
+		}
+		while (FindNextFileA (find, &data));
 
-//------------------------
\ No newline at end of file
+		FindClose (find);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,450 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include <Windows.h>
+#include "Traversal.h"
+
+//--------------------------------
+
+static const char*  CheckpointSignature = "DependencyTree checkpoint 2";
+static const size_t JournalLineLength   = 4096;
+
+//--------------------------------
+
+Traversal::Traversal (DependencyGraph* scan, Exporter* exporter, Expander expander):
+	m_scan         (scan),
+	m_exporter     (exporter),
+	m_expander     (expander),
+	m_order        (DepthFirst),
+	m_checkpoint   (),
+	m_interval     (0),
+	m_frontier     (),
+	m_next_level   (),
+	m_queued       (),
+	m_expanded     (0),
+	m_failed       (0),
+	m_journal      (),
+	m_resumed      (),
+	m_resumed_size (0),
+	m_appending    (false)
+{}
+
+//--------------------------------
+
+void Traversal::setOrder (Order order)
+{
+	m_order = order;
+}
+
+void Traversal::setCheckpoint (const char* filename, int interval)
+{
+	m_checkpoint = filename? filename: "";
+	m_interval   = interval;
+}
+
+//--------------------------------
+
+int Traversal::getExpandedCount () const
+{
+	return m_expanded;
+}
+
+int Traversal::getFailedCount () const
+{
+	return m_failed;
+}
+
+//--------------------------------
+
+void Traversal::addRoot (const char* name)
+{
+	if (!m_checkpoint.empty ())
+		m_journal += std::string ("R ") + name + "\n";
+
+	root (name);
+}
+
+void Traversal::root (const char* name)
+{
+	int module = m_scan -> addModule (name);
+	m_scan -> addFlags (module, DependencyGraph::Root);
+
+	push (module);
+}
+
+//--------------------------------
+
+// Every module enters the frontier at most once. Level order collects the
+// next level separately and sorts it by name before it is expanded, so the
+// output does not depend on the order imports appear in the binaries.
+
+void Traversal::push (int module)
+{
+	if (module >= (int) m_queued.size ())
+		m_queued.resize (m_scan -> getModulesCount ());
+
+	if (m_queued[module] || (m_scan -> getFlags (module) & DependencyGraph::Visited))
+		return;
+
+	m_queued[module] = true;
+
+	if (m_order == LevelOrder) m_next_level.push_back (module);
+	else                       m_frontier  .push_back (module);
+}
+
+int Traversal::pop ()
+{
+	if (m_frontier.empty ())
+	{
+		std::sort (m_next_level.begin (), m_next_level.end (), [this] (int a, int b)
+		{
+			return _stricmp (m_scan -> getModuleName (a), m_scan -> getModuleName (b)) < 0;
+		});
+
+		m_frontier.assign (m_next_level.begin (), m_next_level.end ());
+		m_next_level.clear ();
+	}
+
+	if (m_frontier.empty ())
+		return -1;
+
+	int module = 0;
+	if (m_order == DepthFirst)
+	{
+		module = m_frontier.back ();
+		m_frontier.pop_back ();
+	}
+
+	else
+	{
+		module = m_frontier.front ();
+		m_frontier.pop_front ();
+	}
+
+	return module;
+}
+
+//--------------------------------
+
+void Traversal::run ()
+{
+	for (int module = pop (); module != -1; module = pop ())
+	{
+		expand (module);
+
+		if (!m_checkpoint.empty () && m_interval > 0 && m_expanded % m_interval == 0)
+			save ();
+	}
+
+	if (!m_checkpoint.empty ())
+		save ();
+}
+
+//--------------------------------
+
+void Traversal::expand (int module)
+{
+	m_scan -> addFlags (module, DependencyGraph::Visited);
+	m_expanded++;
+
+	std::vector <std::string> dependencies;
+	bool expanded = m_expander (m_scan, module, &dependencies);
+
+	if (!expanded)
+	{
+		printf ("Warning: Failed to expand '%s', continuing without it\n", m_scan -> getModuleName (module));
+		dependencies.clear ();
+	}
+
+	if (!m_checkpoint.empty ())
+	{
+		char header[32] = "";
+		sprintf_s (header, "X %d %u ", expanded, m_scan -> getFlags (module));
+
+		m_journal += header;
+		m_journal += m_scan -> getModuleName (module);
+		m_journal += "\n";
+
+		for (const std::string& symbol: m_scan -> getImports (module))
+			m_journal += "I " + symbol + "\n";
+
+		for (const std::string& dependency: dependencies)
+			m_journal += "D " + dependency + "\n";
+	}
+
+	finish (module, expanded, dependencies);
+}
+
+// Edges into a module are reported once its flags are known: those found
+// before it was expanded are reported here, later ones by connect ().
+
+void Traversal::finish (int module, bool expanded, const std::vector <std::string>& dependencies)
+{
+	if (!expanded)
+	{
+		m_scan -> addFlags (module, DependencyGraph::Failed);
+		m_failed++;
+	}
+
+	const char* name  = m_scan -> getModuleName (module);
+	unsigned    flags = m_scan -> getFlags      (module);
+
+	m_exporter -> node (name, flags);
+	for (int dependent: m_scan -> getDependents (module))
+		m_exporter -> edge (m_scan -> getModuleName (dependent), name, flags);
+
+	std::vector <int> targets;
+	targets.reserve (dependencies.size ());
+
+	for (const std::string& dependency: dependencies)
+		targets.push_back (m_scan -> addModule (dependency.c_str ()));
+
+	// Depth first pops from the back, push in reverse to expand the
+	// imports in the order they are listed
+	if (m_order == DepthFirst)
+		std::reverse (targets.begin (), targets.end ());
+
+	for (int target: targets)
+		connect (module, target);
+}
+
+void Traversal::connect (int from, int to)
+{
+	if (!m_scan -> addEdge (from, to))
+		return;
+
+	if (from == to)
+		m_scan -> addFlags (to, DependencyGraph::SelfImport);
+
+	if (m_scan -> getFlags (to) & DependencyGraph::Visited)
+		m_exporter -> edge (m_scan -> getModuleName (from), m_scan -> getModuleName (to), m_scan -> getFlags (to));
+
+	else push (to);
+}
+
+//--------------------------------
+
+/*
+
+	Checkpoint journal, one record per line:
+
+	    DependencyTree checkpoint 2
+	    O <order>                     traversal order the journal replays in
+	    B                             start of a checkpoint
+	    R <name>                      root added
+	    X <expanded> <flags> <name>   module popped from the frontier and
+	    I <symbol>                    what the expander found: its flags,
+	    D <name>                      imports and dependencies, in order
+	    C                             end of a checkpoint
+
+	Every checkpoint only appends what happened since the previous one, so
+	the import lists and the rest of the scan are written once in total.
+	A checkpoint torn by a crash lacks its "C" line and is dropped on
+	resume, its modules are then expanded again. The first checkpoint of
+	a walk writes the file from scratch (or from the part of the journal
+	it was resumed from) next to the target and moves it over.
+
+*/
+
+bool Traversal::save ()
+{
+	if (m_journal.empty () && m_appending)
+		return true;
+
+	std::string target = m_appending? m_checkpoint: m_checkpoint + ".tmp";
+
+	FILE* file = nullptr;
+	if (fopen_s (&file, target.c_str (), m_appending? "ab": "wb") || !file)
+	{
+		printf ("Warning: Failed to open '%s' for writing\n", target.c_str ());
+		return false;
+	}
+
+	bool ok = true;
+	if (!m_appending && !m_resumed.empty ())
+	{
+		FILE* resumed = nullptr;
+		ok = !fopen_s (&resumed, m_resumed.c_str (), "rb") && resumed;
+
+		char    buffer[64 * 1024] = "";
+		int64_t left              = m_resumed_size;
+
+		while (ok && left > 0)
+		{
+			size_t size = (size_t) std::min <int64_t> (left, sizeof (buffer));
+
+			ok    = fread (buffer, 1, size, resumed) == size && fwrite (buffer, 1, size, file) == size;
+			left -= size;
+		}
+
+		if (resumed)
+			fclose (resumed);
+	}
+
+	else if (!m_appending)
+		fprintf (file, "%s\nO %d\n", CheckpointSignature, (int) m_order);
+
+	fputs   ("B\n",               file);
+	fwrite  (m_journal.data (), 1, m_journal.size (), file);
+	fputs   ("C\n",               file);
+
+	ok = !ferror (file) && ok;
+	ok = fclose (file) == 0 && ok;
+
+	if (ok && !m_appending && !MoveFileExA (target.c_str (), m_checkpoint.c_str (), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		printf ("Warning: Failed to replace checkpoint '%s' (error %lu)\n", m_checkpoint.c_str (), GetLastError ());
+		ok = false;
+	}
+
+	if (!ok)
+	{
+		// A failed append is repeated with the next checkpoint, after a "B"
+		// that drops whatever part of it made it to the file
+		if (!m_appending) DeleteFileA (target.c_str ());
+		else              printf ("Warning: Failed to append to checkpoint '%s'\n", m_checkpoint.c_str ());
+
+		return false;
+	}
+
+	m_journal.clear ();
+	m_resumed.clear ();
+	m_appending = true;
+
+	return true;
+}
+
+//--------------------------------
+
+// Replays the journal through the same frontier as the original walk, so
+// the modules are popped in the same order and the exporter gets the same
+// nodes and edges. The order of the journal overrides the one set.
+
+bool Traversal::resume (const char* filename)
+{
+	FILE* file = nullptr;
+	if (fopen_s (&file, filename, "rb") || !file)
+	{
+		printf ("Warning: Failed to open '%s' for reading\n", filename);
+		return false;
+	}
+
+	char line[JournalLineLength] = "";
+	int  order                   = -1;
+
+	if (!fgets (line, sizeof (line), file) || strncmp (line, CheckpointSignature, strlen (CheckpointSignature)) != 0 ||
+	    !fgets (line, sizeof (line), file) || sscanf_s (line, "O %d", &order) != 1 || order < BreadthFirst || order > LevelOrder)
+	{
+		printf ("Warning: '%s' is not a traversal checkpoint\n", filename);
+		fclose (file);
+		return false;
+	}
+
+	m_scan -> clear ();
+	m_frontier  .clear ();
+	m_next_level.clear ();
+	m_queued    .clear ();
+
+	m_order    = (Order) order;
+	m_expanded = 0;
+	m_failed   = 0;
+
+	int64_t                   replayed = _ftelli64 (file);
+	std::vector <std::string> batch;
+
+	bool ok = true;
+	while (ok && fgets (line, sizeof (line), file))
+	{
+		line[strcspn (line, "\r\n")] = '\0';
+
+		if (!strcmp (line, "B"))
+			batch.clear ();
+
+		else if (!strcmp (line, "C"))
+		{
+			ok       = replay (batch);
+			replayed = _ftelli64 (file);
+
+			batch.clear ();
+		}
+
+		else batch.push_back (line);
+	}
+
+	fclose (file);
+
+	if (!ok)
+	{
+		printf ("Warning: Checkpoint '%s' is corrupted\n", filename);
+
+		m_scan -> clear ();
+		m_frontier  .clear ();
+		m_next_level.clear ();
+		m_queued    .clear ();
+
+		m_expanded = 0;
+		m_failed   = 0;
+
+		return false;
+	}
+
+	m_resumed      = filename;
+	m_resumed_size = replayed;
+	m_appending    = false;
+
+	return true;
+}
+
+//--------------------------------
+
+bool Traversal::replay (const std::vector <std::string>& batch)
+{
+	for (size_t i = 0; i < batch.size (); )
+	{
+		const std::string& record = batch[i++];
+
+		if (!record.compare (0, 2, "R "))
+		{
+			root (record.c_str () + 2);
+			continue;
+		}
+
+		if (record.compare (0, 2, "X "))
+			return false;
+
+		char*    rest     = nullptr;
+		bool     expanded = strtol  (record.c_str () + 2, &rest, 10) != 0;
+		unsigned flags    = strtoul (rest,                &rest, 10);
+
+		if (*rest != ' ')
+			return false;
+
+		// The walk has to pop the very module the journal recorded
+		int module = pop ();
+		if (module == -1 || _stricmp (m_scan -> getModuleName (module), rest + 1) != 0)
+			return false;
+
+		m_scan -> addFlags (module, DependencyGraph::Visited | flags);
+		m_expanded++;
+
+		std::vector <std::string> imports;
+		std::vector <std::string> dependencies;
+
+		for (; i < batch.size () && !batch[i].compare (0, 2, "I "); i++) imports     .push_back (batch[i].substr (2));
+		for (; i < batch.size () && !batch[i].compare (0, 2, "D "); i++) dependencies.push_back (batch[i].substr (2));
+
+		if (!std::is_sorted (imports.begin (), imports.end ()))
+			return false;
+
+		if (!imports.empty ())
+			m_scan -> setImports (module, std::make_shared <const std::vector <std::string>> (std::move (imports)));
+
+		finish (module, expanded, dependencies);
+	}
+
+	return true;
+}
+
+//--------------------------------
@@ -0,0 +1,83 @@
+#pragma once
+
+//--------------------------------
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "DependencyGraph.h"
+#include "Exporter.h"
+
+//--------------------------------
+
+// Worklist driven crawl over the import graph.
+//
+// Modules are expanded from an explicit frontier instead of the call
+// stack, so there is no depth limit, and a module that fails to parse is
+// flagged (DependencyGraph::Failed) without stopping the rest of the
+// walk. The walk can be checkpointed periodically and resumed after a
+// crash: the checkpoint is an append-only journal of the roots and of what
+// every expansion found, which a resume replays to rebuild the frontier
+// and the scan (whose Visited flags are the visited set).
+//
+// The expander loads a single module, records its flags and imports in
+// the scan and returns the names of the modules it depends on. Returning
+// false marks the module as failed.
+
+class Traversal
+{
+public :
+	enum Order
+	{
+		BreadthFirst,
+		DepthFirst,
+		LevelOrder
+	};
+
+	typedef std::function <bool (DependencyGraph* scan, int module, std::vector <std::string>* dependencies)> Expander;
+
+	Traversal (DependencyGraph* scan, Exporter* exporter, Expander expander);
+
+	void setOrder      (Order order);
+	void setCheckpoint (const char* filename, int interval);
+
+	void addRoot (const char* name);
+	bool resume  (const char* filename);
+	void run     ();
+
+	int getExpandedCount () const;
+	int getFailedCount   () const;
+
+private :
+	DependencyGraph*   m_scan;
+	Exporter*          m_exporter;
+	Expander           m_expander;
+	Order              m_order;
+	std::string        m_checkpoint;
+	int                m_interval;
+	std::deque <int>   m_frontier;
+	std::vector <int>  m_next_level;
+	std::vector <bool> m_queued;
+	int                m_expanded;
+	int                m_failed;
+
+	std::string        m_journal;      // Records since the last checkpoint
+	std::string        m_resumed;      // Journal the walk was resumed from
+	int64_t            m_resumed_size; // Its part that was replayed
+	bool               m_appending;    // Whether the checkpoint file is ours to append to
+
+	void root    (const char* name);
+	void push    (int module);
+	int  pop     ();
+	void expand  (int module);
+	void finish  (int module, bool expanded, const std::vector <std::string>& dependencies);
+	void connect (int from, int to);
+	bool replay  (const std::vector <std::string>& batch);
+	bool save    ();
+
+};
+
+//--------------------------------